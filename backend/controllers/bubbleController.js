@@ -1,58 +1,29 @@
-import { exec } from 'child_process';
-import { promisify } from 'util';
-import path from 'path';
-import { fileURLToPath } from 'url';
-
-const execAsync = promisify(exec);
-const __filename = fileURLToPath(import.meta.url);
-const __dirname = path.dirname(__filename);
+import { integerArgs, optionArgs } from '../services/enginePool.js';
+import { sendSteps } from '../services/stepStream.js';
 
 /**
- * Execute bubble sort C++ program and return steps
+ * Execute bubble sort C++ program and stream its steps
  */
 export const runBubbleSort = async (req, res) => {
   try {
-    const { array } = req.body;
+    const { array, options } = req.body;
 
     if (!array || !Array.isArray(array)) {
       return res.status(400).json({ error: 'Array is required in request body' });
     }
 
-    // Convert array to space-separated string for C++ program
-    const arrayString = array.join(' ');
-
-    // Path to compiled C++ executable (Windows uses .exe, Unix doesn't)
-    const isWindows = process.platform === 'win32';
-    const executableName = isWindows ? 'bubble.exe' : 'bubble';
-    const cppExecutable = path.join(__dirname, '../cpp/build', executableName);
-
-    // Execute C++ program with array as input
-    const { stdout, stderr } = await execAsync(
-      `"${cppExecutable}" ${arrayString}`,
-      { maxBuffer: 10 * 1024 * 1024 } // 10MB buffer
-    );
-
-    if (stderr) {
-      console.error('C++ program stderr:', stderr);
+    // Each array element becomes one argument for the C++ program
+    const values = integerArgs(array);
+    if (!values) {
+      return res.status(400).json({ error: 'Array elements must be integers' });
     }
-
-    // Parse JSON steps from stdout
-    const steps = [];
-    const lines = stdout.trim().split('\n');
-    
-    for (const line of lines) {
-      if (line.trim()) {
-        try {
-          const step = JSON.parse(line);
-          steps.push(step);
-        } catch (e) {
-          // Skip invalid JSON lines
-          console.warn('Skipping invalid JSON line:', line);
-        }
-      }
+    const flags = optionArgs('bubble', options);
+    if (!flags) {
+      return res.status(400).json({ error: 'options hold an unknown option or a value out of range' });
     }
+    const args = [...flags, ...values];
 
-    res.json({ steps, originalArray: array });
+    await sendSteps(res, 'bubble', args, { originalArray: array });
   } catch (error) {
     console.error('Error executing bubble sort:', error);
     res.status(500).json({ error: 'Failed to execute bubble sort', details: error.message });
@@ -1,57 +1,49 @@
-import { exec } from 'child_process';
-import { promisify } from 'util';
-import path from 'path';
-import { fileURLToPath } from 'url';
-
-const execAsync = promisify(exec);
-const __filename = fileURLToPath(import.meta.url);
-const __dirname = path.dirname(__filename);
+import { integerArgs, optionArgs } from '../services/enginePool.js';
+import { sendSteps } from '../services/stepStream.js';
 
 /**
- * Execute Dijkstra's algorithm C++ program and return steps
+ * Execute Dijkstra's algorithm C++ program and stream its steps
  */
 export const runDijkstra = async (req, res) => {
   try {
-    const { numNodes, startNode, edges } = req.body;
+    const { numNodes, startNode, targetNode, coordinates, edges, options } = req.body;
 
     if (numNodes === undefined || numNodes === null || startNode === undefined || startNode === null || !edges || !Array.isArray(edges)) {
       return res.status(400).json({ error: 'numNodes, startNode, and edges array are required' });
     }
+    if (coordinates !== undefined && (!Array.isArray(coordinates) || coordinates.length !== Number(numNodes)
+        || !coordinates.every(point => point && Number.isFinite(Number(point.x)) && Number.isFinite(Number(point.y))))) {
+      return res.status(400).json({ error: 'coordinates must hold one { x, y } per node' });
+    }
+    if (targetNode !== undefined && targetNode !== null && integerArgs([targetNode]) === null) {
+      return res.status(400).json({ error: 'targetNode must be an integer' });
+    }
+
+    // Point-to-point query: stop at targetNode, with A* when coordinates are given
+    const queryOptions = { ...options };
+    if (targetNode !== undefined && targetNode !== null) {
+      queryOptions.target = targetNode;
+    }
+    if (coordinates) {
+      queryOptions.coords = coordinates.map(point => `${Number(point.x)},${Number(point.y)}`).join(',');
+    }
 
     // Build command arguments: numNodes startNode edge1_u edge1_v weight1 edge2_u edge2_v weight2 ...
-    const args = [numNodes.toString(), startNode.toString()];
+    const values = [numNodes, startNode];
     edges.forEach(edge => {
-      args.push(edge.u.toString(), edge.v.toString(), (edge.weight || 1).toString());
+      values.push(edge.u, edge.v, edge.weight || 1);
     });
-
-    const isWindows = process.platform === 'win32';
-    const executableName = isWindows ? 'dijkstra.exe' : 'dijkstra';
-    const cppExecutable = path.join(__dirname, '../cpp/build', executableName);
-
-    const { stdout, stderr } = await execAsync(
-      `"${cppExecutable}" ${args.join(' ')}`,
-      { maxBuffer: 10 * 1024 * 1024 }
-    );
-
-    if (stderr) {
-      console.error('C++ program stderr:', stderr);
+    const positional = integerArgs(values);
+    if (!positional) {
+      return res.status(400).json({ error: 'numNodes, startNode, edge endpoints and weights must be integers' });
     }
-
-    const steps = [];
-    const lines = stdout.trim().split('\n');
-    
-    for (const line of lines) {
-      if (line.trim()) {
-        try {
-          const step = JSON.parse(line);
-          steps.push(step);
-        } catch (e) {
-          console.warn('Skipping invalid JSON line:', line);
-        }
-      }
+    const flags = optionArgs('dijkstra', queryOptions);
+    if (!flags) {
+      return res.status(400).json({ error: 'options hold an unknown option or a value out of range' });
     }
+    const args = [...flags, ...positional];
 
-    res.json({ steps, numNodes, startNode, edges });
+    await sendSteps(res, 'dijkstra', args, { numNodes, startNode, targetNode, edges });
   } catch (error) {
     console.error('Error executing Dijkstra:', error);
     res.status(500).json({ error: 'Failed to execute Dijkstra', details: error.message });
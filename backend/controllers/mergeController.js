@@ -1,52 +1,27 @@
-import { exec } from 'child_process';
-import { promisify } from 'util';
-import path from 'path';
-import { fileURLToPath } from 'url';
-
-const execAsync = promisify(exec);
-const __filename = fileURLToPath(import.meta.url);
-const __dirname = path.dirname(__filename);
+import { integerArgs, optionArgs } from '../services/enginePool.js';
+import { sendSteps } from '../services/stepStream.js';
 
 /**
- * Execute merge sort C++ program and return steps
+ * Execute merge sort C++ program and stream its steps
  */
 export const runMergeSort = async (req, res) => {
   try {
-    const { array } = req.body;
+    const { array, options } = req.body;
 
     if (!array || !Array.isArray(array)) {
       return res.status(400).json({ error: 'Array is required in request body' });
     }
 
-    const arrayString = array.join(' ');
-    const isWindows = process.platform === 'win32';
-    const executableName = isWindows ? 'merge.exe' : 'merge';
-    const cppExecutable = path.join(__dirname, '../cpp/build', executableName);
-
-    const { stdout, stderr } = await execAsync(
-      `"${cppExecutable}" ${arrayString}`,
-      { maxBuffer: 10 * 1024 * 1024 }
-    );
-
-    if (stderr) {
-      console.error('C++ program stderr:', stderr);
+    const values = integerArgs(array);
+    if (!values) {
+      return res.status(400).json({ error: 'Array elements must be integers' });
     }
-
-    const steps = [];
-    const lines = stdout.trim().split('\n');
-    
-    for (const line of lines) {
-      if (line.trim()) {
-        try {
-          const step = JSON.parse(line);
-          steps.push(step);
-        } catch (e) {
-          console.warn('Skipping invalid JSON line:', line);
-        }
-      }
+    const flags = optionArgs('merge', options);
+    if (!flags) {
+      return res.status(400).json({ error: 'options hold an unknown option or a value out of range' });
     }
-
-    res.json({ steps, originalArray: array });
+    const args = [...flags, ...values];
+    await sendSteps(res, 'merge', args, { originalArray: array });
   } catch (error) {
     console.error('Error executing merge sort:', error);
     res.status(500).json({ error: 'Failed to execute merge sort', details: error.message });
@@ -0,0 +1,30 @@
+import { integerArgs, optionArgs } from '../services/enginePool.js';
+import { sendSteps } from '../services/stepStream.js';
+
+/**
+ * Execute pdqsort C++ program and stream its steps
+ */
+export const runPdqSort = async (req, res) => {
+  try {
+    const { array, options } = req.body;
+
+    if (!array || !Array.isArray(array)) {
+      return res.status(400).json({ error: 'Array is required in request body' });
+    }
+
+    const values = integerArgs(array);
+    if (!values) {
+      return res.status(400).json({ error: 'Array elements must be integers' });
+    }
+    const flags = optionArgs('pdqsort', options);
+    if (!flags) {
+      return res.status(400).json({ error: 'options hold an unknown option or a value out of range' });
+    }
+    const args = [...flags, ...values];
+    await sendSteps(res, 'pdqsort', args, { originalArray: array });
+  } catch (error) {
+    console.error('Error executing pdqsort:', error);
+    res.status(500).json({ error: 'Failed to execute pdqsort', details: error.message });
+  }
+};
+
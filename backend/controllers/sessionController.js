@@ -0,0 +1,40 @@
+import { closeSession, nextPage } from '../services/traceSessions.js';
+import { pageBody, pageSize } from '../services/stepStream.js';
+
+/**
+ * Send the next page of a paged trace: { steps, done }
+ */
+export const getNextPage = async (req, res) => {
+  try {
+    const size = pageSize(req.body && req.body.pageSize);
+    if (size === 0) {
+      return res.status(400).json({ error: 'pageSize must be a positive number of steps' });
+    }
+
+    const page = await nextPage(req.params.id, size);
+    if (!page) {
+      return res.status(404).json({ error: 'Unknown or finished session' });
+    }
+
+    res.status(200).type('application/json');
+    res.end(pageBody(page.steps, { done: page.done }));
+  } catch (error) {
+    console.error('Error reading trace session:', error);
+    res.status(500).json({ error: 'Failed to continue the trace', details: error.message });
+  }
+};
+
+/**
+ * Stop a paged trace before its end
+ */
+export const deleteSession = async (req, res) => {
+  try {
+    if (!(await closeSession(req.params.id))) {
+      return res.status(404).json({ error: 'Unknown or finished session' });
+    }
+    res.status(204).end();
+  } catch (error) {
+    console.error('Error closing trace session:', error);
+    res.status(500).json({ error: 'Failed to close the session', details: error.message });
+  }
+};
@@ -0,0 +1,26 @@
+#ifndef ALGORITHMS_H
+#define ALGORITHMS_H
+
+/**
+ * Algorithm entry points
+ * Each function takes the same arguments as the standalone program
+ * (argv[0] is the program name) and returns its exit code.
+ * The standalone binaries wrap one of these in main(); the engine
+ * (engine.cpp) links all of them into a single long-lived process.
+ */
+
+int runBubbleSort(int argc, char* argv[]);
+int runSelectionSort(int argc, char* argv[]);
+int runInsertionSort(int argc, char* argv[]);
+int runMergeSort(int argc, char* argv[]);
+int runPdqSort(int argc, char* argv[]);
+int runRadixSort(int argc, char* argv[]);
+
+int runBFS(int argc, char* argv[]);
+int runDFS(int argc, char* argv[]);
+int runDijkstra(int argc, char* argv[]);
+int runBellmanFord(int argc, char* argv[]);
+int runFloydWarshall(int argc, char* argv[]);
+
+#endif
+
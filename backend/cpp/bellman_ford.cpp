@@ -1,96 +1,305 @@
 #include <iostream>
 #include <vector>
 #include <climits>
+#include <atomic>
+#include <deque>
+#include <algorithm>
 #include <sstream>
 #include <cstdlib>
 
+#include "algorithms.h"
+#include "csr_graph.h"
+#include "graph_input.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "parallel.h"
+#include "step_writer.h"
+
 using namespace std;
 
 /**
  * Bellman-Ford Algorithm
  * Input format: <num_nodes> <start_node> <edge1_u> <edge1_v> <weight> <edge2_u> <edge2_v> <weight> ...
+ * (edges may instead come from --stdin or a --graph=<file> CSR file, see graph_input.h)
  * Outputs JSON steps for visualization
+ *
+ * Relaxation strategies (the negative cycle check afterwards is the same):
+ *   default        numNodes - 1 passes over every edge
+ *   --early-exit   stop after the first pass that changes nothing
+ *   --spfa         queue-based: relax only out-arcs of changed nodes,
+ *                  traced with enqueue/dequeue steps
+ *   --parallel     edge-partitioned passes on --threads=<n> workers with
+ *                  early exit; no per-edge relax steps, and --keyframes
+ *                  only between passes
  */
 
-void outputStep(const string& type, int node1 = -1, int node2 = -1, int value = -1, const string& extra = "") {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
+static void outputStep(const char* type, int node1 = -1, int node2 = -1, int value = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
     if (node1 != -1) {
-        cout << ",\"node\":" << node1;
+        out.field("node", node1);
     }
     if (node2 != -1) {
-        cout << ",\"target\":" << node2;
+        out.field("target", node2);
     }
     if (value != -1) {
-        cout << ",\"distance\":" << value;
+        out.field("distance", value);
     }
-    if (!extra.empty()) {
-        cout << "," << extra;
+    out.endStep();
+}
+
+// Keyframe: every distance (-1 while unreached) and, for SPFA, the queue
+static void outputKeyframe(Keyframes& keyframes, const vector<int>& dist, const deque<int>* queue = nullptr) {
+    StepWriter& out = stepWriter();
+    keyframes.begin();
+    out.beginList("distance");
+    for (int d : dist) {
+        out.item(d == INT_MAX ? -1 : d);
+    }
+    out.endList();
+    if (queue) {
+        out.beginList("frontier");
+        for (int node : *queue) {
+            out.item(node);
+        }
+        out.endList();
     }
-    cout << "}" << endl;
+    keyframes.end();
 }
 
-struct Edge {
-    int u, v, weight;
-};
+static const size_t EDGE_GRAIN = 4096;
 
-int main(int argc, char* argv[]) {
-    if (argc < 5) {
+/**
+ * Classic passes over the edge list in input order. With earlyExit the
+ * passes stop once one of them changes nothing, since later passes could
+ * not change anything either.
+ */
+static void relaxPasses(const EdgeList& edges, vector<int>& dist, bool earlyExit, Keyframes& keyframes) {
+    int numNodes = (int)dist.size();
+    size_t numEdges = edges.size();
+    OpCounters& ops = runMetrics().ops;
+
+    // Relax edges (V-1) times
+    for (int i = 0; i < numNodes - 1; i++) {
+        outputStep("iteration", -1, -1, i + 1);
+        bool changed = false;
+        
+        for (size_t e = 0; e < numEdges; e++) {
+            int u = edges.u[e], v = edges.v[e], weight = edges.w[e];
+            outputStep("relax", u, v, weight);
+            ops.relaxations++;
+            
+            if (dist[u] != INT_MAX && dist[u] + weight < dist[v]) {
+                dist[v] = dist[u] + weight;
+                outputStep("update_distance", v, -1, dist[v]);
+                changed = true;
+            }
+            if (keyframes.due()) {
+                outputKeyframe(keyframes, dist);
+            }
+        }
+
+        if (earlyExit && !changed) break;
+    }
+}
+
+/**
+ * Queue-based Bellman-Ford (SPFA): only the out-arcs of nodes whose
+ * distance changed are relaxed again. A shortest path that needs numNodes
+ * or more edges means a reachable negative cycle; the search stops there
+ * and the usual edge check reports it.
+ */
+static void relaxQueue(const CsrGraph& graph, vector<int>& dist, int startNode, Keyframes& keyframes) {
+    int numNodes = graph.numNodes;
+    vector<bool> inQueue(numNodes, false);
+    vector<int> pathEdges(numNodes, 0);
+    deque<int> queue;
+    OpCounters& ops = runMetrics().ops;
+
+    queue.push_back(startNode);
+    ops.pushes++;
+    inQueue[startNode] = true;
+    outputStep("enqueue", startNode);
+
+    while (!queue.empty()) {
+        if (keyframes.due()) {
+            outputKeyframe(keyframes, dist, &queue);
+        }
+        int u = queue.front();
+        queue.pop_front();
+        ops.pops++;
+        inQueue[u] = false;
+        outputStep("dequeue", u);
+
+        for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+            int v = graph.targets[a], weight = graph.weights[a];
+            outputStep("relax", u, v, weight);
+            ops.relaxations++;
+
+            if (dist[u] + weight < dist[v]) {
+                dist[v] = dist[u] + weight;
+                outputStep("update_distance", v, -1, dist[v]);
+                pathEdges[v] = pathEdges[u] + 1;
+                if (pathEdges[v] >= numNodes) return;
+                if (!inQueue[v]) {
+                    queue.push_back(v);
+                    ops.pushes++;
+                    inQueue[v] = true;
+                    outputStep("enqueue", v);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Passes with the edge list split across the worker pool. Distances are
+ * lowered with an atomic min, so a pass may already see values from the
+ * same pass; that only speeds up convergence. Each pass is traced as one
+ * iteration step plus an update_distance step per node it changed. Stops
+ * early once a pass changes nothing.
+ */
+static void relaxParallel(const EdgeList& edges, vector<int>& result, WorkerPool& pool, Keyframes& keyframes) {
+    int numNodes = (int)result.size();
+    vector<atomic<int>> dist(numNodes);
+    for (int v = 0; v < numNodes; v++) {
+        dist[v].store(result[v], memory_order_relaxed);
+    }
+    vector<vector<int>> changed(pool.size());
+    vector<int> lastPass(numNodes, 0);
+    vector<int> updated;
+    OpCounters& ops = runMetrics().ops;
+
+    for (int i = 0; i < numNodes - 1; i++) {
+        ops.relaxations += edges.size();
+        pool.parallelFor(edges.size(), EDGE_GRAIN, [&](size_t begin, size_t end, int worker) {
+            for (size_t e = begin; e < end; e++) {
+                int du = dist[edges.u[e]].load(memory_order_relaxed);
+                if (du == INT_MAX) continue;
+                int candidate = du + edges.w[e];
+                atomic<int>& dv = dist[edges.v[e]];
+                int current = dv.load(memory_order_relaxed);
+                while (candidate < current) {
+                    if (dv.compare_exchange_weak(current, candidate, memory_order_relaxed)) {
+                        changed[worker].push_back(edges.v[e]);
+                        break;
+                    }
+                }
+            }
+        });
+
+        updated.clear();
+        for (vector<int>& nodes : changed) {
+            for (int v : nodes) {
+                if (lastPass[v] != i + 1) {
+                    lastPass[v] = i + 1;
+                    updated.push_back(v);
+                }
+            }
+            nodes.clear();
+        }
+        if (updated.empty()) break;
+
+        outputStep("iteration", -1, -1, i + 1);
+        sort(updated.begin(), updated.end());
+        for (int v : updated) {
+            outputStep("update_distance", v, -1, dist[v].load(memory_order_relaxed));
+        }
+
+        if (keyframes.due()) {
+            for (int v = 0; v < numNodes; v++) {
+                result[v] = dist[v].load(memory_order_relaxed);
+            }
+            outputKeyframe(keyframes, result);
+        }
+    }
+
+    for (int v = 0; v < numNodes; v++) {
+        result[v] = dist[v].load(memory_order_relaxed);
+    }
+}
+
+int runBellmanFord(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
+    if (argc < 3) {
         cerr << "Usage: " << argv[0] << " <num_nodes> <start_node> <edge1_u> <edge1_v> <weight> ..." << endl;
         return 1;
     }
 
-    int numNodes = atoi(argv[1]);
+    GraphInput input;
+    if (!loadGraph(opts, argc, argv, 3, true, input)) {
+        return 1;
+    }
     int startNode = atoi(argv[2]);
-    
-    vector<Edge> edges;
-    
-    // Parse edges with weights
-    for (int i = 3; i < argc; i += 3) {
-        if (i + 2 < argc) {
-            int u = atoi(argv[i]);
-            int v = atoi(argv[i + 1]);
-            int weight = atoi(argv[i + 2]);
-            if (u >= 0 && u < numNodes && v >= 0 && v < numNodes) {
-                edges.push_back({u, v, weight});
-            }
-        }
+    if (startNode < 0 || startNode >= input.numNodes) {
+        cerr << "start_node " << startNode << " is not a node" << endl;
+        return 1;
+    }
+
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"initialize", "iteration"}, "node target distance", TRACE_SUMMARY);
+    out.declareSteps({"relax"}, "node target distance");
+    out.declareSteps({"update_distance"}, "node target distance", TRACE_EVENTS);
+    out.declareSteps({"check_negative_cycle"}, "node target distance", TRACE_SUMMARY);
+    out.declareSteps({"negative_cycle", "final_distance"}, "node target distance", TRACE_RESULT);
+    if (opts.has("spfa")) {
+        out.declareSteps({"enqueue", "dequeue"}, "node target distance", TRACE_EVENTS);
     }
+    Keyframes keyframes(opts);
+
+    int numNodes = input.numNodes;
+    
+    // Directed graph, relaxed edge by edge in input order
+    metrics.phase(PHASE_BUILD);
+    CsrGraph graph;
+    graph.build(input, CSR_WEIGHTED | CSR_EDGE_LIST);
+    const EdgeList& edges = graph.edges;
+    size_t numEdges = edges.size();
+    metrics.phase(PHASE_RUN);
 
     vector<int> dist(numNodes, INT_MAX);
     dist[startNode] = 0;
     
     outputStep("initialize", startNode, -1, 0);
     
-    // Relax edges (V-1) times
-    for (int i = 0; i < numNodes - 1; i++) {
-        outputStep("iteration", -1, -1, i + 1);
-        
-        for (const Edge& e : edges) {
-            outputStep("relax", e.u, e.v, e.weight);
-            
-            if (dist[e.u] != INT_MAX && dist[e.u] + e.weight < dist[e.v]) {
-                dist[e.v] = dist[e.u] + e.weight;
-                outputStep("update_distance", e.v, -1, dist[e.v]);
-            }
-        }
+    if (opts.has("spfa")) {
+        relaxQueue(graph, dist, startNode, keyframes);
+    } else if (opts.has("parallel")) {
+        WorkerPool pool(threadCount(opts));
+        relaxParallel(edges, dist, pool, keyframes);
+    } else {
+        relaxPasses(edges, dist, opts.has("early-exit"), keyframes);
     }
     
     // Check for negative cycles
     outputStep("check_negative_cycle");
-    for (const Edge& e : edges) {
-        if (dist[e.u] != INT_MAX && dist[e.u] + e.weight < dist[e.v]) {
-            outputStep("negative_cycle", e.u, e.v);
+    metrics.ops.relaxations += numEdges;
+    for (size_t e = 0; e < numEdges; e++) {
+        int u = edges.u[e], v = edges.v[e], weight = edges.w[e];
+        if (dist[u] != INT_MAX && dist[u] + weight < dist[v]) {
+            outputStep("negative_cycle", u, v);
         }
     }
     
     // Output final distances
+    metrics.phase(PHASE_EMIT);
     for (int i = 0; i < numNodes; i++) {
         if (dist[i] != INT_MAX) {
             outputStep("final_distance", i, -1, dist[i]);
         }
     }
 
+    finishMetrics();
+
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runBellmanFord(argc, argv);
+}
+#endif
+
@@ -0,0 +1,426 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+#include "../algorithms.h"
+#include "../options.h"
+#include "../step_writer.h"
+
+using namespace std;
+
+/**
+ * Algorithm Benchmark Suite
+ * Runs every algorithm in-process (linked like the engine) on seeded
+ * synthetic inputs across three sizes per family, with the trace on
+ * (full NDJSON) and off (--verbosity=result), and reports the best time
+ * of --repeat runs:
+ *   sorts           random, sorted, reversed and few-unique arrays
+ *   BFS, DFS        sparse random, 2D grid and dense random graphs
+ *   Dijkstra        the same graphs with weights in [1, 100]
+ *   Bellman-Ford    DAGs with weights in [-10, 50] (no negative cycles)
+ *   Floyd-Warshall  dense random directed graphs, and DAGs with weights in
+ *                   [-10000, 10000]
+ * A few cases also run the optional modes (--natural, --heap, --spfa,
+ * --blocked, ...) so each of them can be compared with the default.
+ *
+ * Usage: algorithm_bench [--scale=<s>] [--repeat=<n>] [--filter=<text>]
+ *                        [--out=<file>] [--baseline=<file>] [--tolerance=<pct>]
+ *                        [--check]
+ *   --scale       multiplies every input size (default 1)
+ *   --filter      only run cases whose name contains the text
+ *   --out         write the results there instead of stdout
+ *   --baseline    compare with an earlier --out file and exit with 1 if any
+ *                 case got slower by more than --tolerance percent
+ *                 (default 10); baselines under 1 ms are too noisy and
+ *                 are not compared
+ *   --check       also check that each case's --verbosity=result steps are
+ *                 exactly the result-level steps of its full trace, in
+ *                 order, and exit with 1 if not: verbosity may only filter
+ *                 what is written, never change the result. Modes that
+ *                 promise another mode's results (--johnson and --blocked)
+ *                 are compared with it on the same input too
+ *
+ * Results are CSV: case,trace,ms,steps,bytes where case is
+ * algorithm[+mode]/family/size, trace is on or off and steps counts the
+ * trace lines written.
+ */
+
+struct BenchCase {
+    string name;
+    int (*run)(int argc, char* argv[]);
+    vector<string> flags;
+    function<vector<string>(mt19937&)> input;
+    // For --check: flags of another mode that must give the same results
+    vector<string> reference;
+};
+
+struct Result {
+    string name;
+    string trace;
+    double milliseconds;
+    long long steps;
+    long long bytes;
+};
+
+// Discards the trace, counting its bytes and lines; kept, if set, gets a copy
+class CountingStreamBuf : public streambuf {
+public:
+    CountingStreamBuf() : bytes(0), lines(0), kept(nullptr) {}
+
+    long long bytes;
+    long long lines;
+    string* kept;
+
+protected:
+    streamsize xsputn(const char* data, streamsize size) override {
+        bytes += size;
+        if (kept) kept->append(data, size);
+        lines += count(data, data + size, '\n');
+        return size;
+    }
+
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            char ch = (char)c;
+            xsputn(&ch, 1);
+        }
+        return traits_type::not_eof(c);
+    }
+};
+
+// FNV-1a, so every case gets the same input whatever else is filtered out
+static uint32_t seedFor(const string& name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash = (hash ^ (unsigned char)c) * 16777619u;
+    }
+    return hash;
+}
+
+static vector<string> makeArray(int n, const string& family, mt19937& rng) {
+    vector<int> values(n);
+    for (int i = 0; i < n; i++) {
+        values[i] = family == "few_unique" ? (int)(rng() % 10) : (int)(rng() % 1000000);
+    }
+    if (family == "sorted") sort(values.begin(), values.end());
+    if (family == "reversed") sort(values.rbegin(), values.rend());
+
+    vector<string> args;
+    for (int value : values) {
+        args.push_back(to_string(value));
+    }
+    return args;
+}
+
+/**
+ * Graph arguments: <num_nodes> [<start_node>] then the edges. Weights are
+ * uniform in [minWeight, maxWeight] when weighted. A "dag" only has edges
+ * from lower to higher node ids; a "looped" DAG also has a self-loop with
+ * a weight in [0, maxWeight] on every fourth node.
+ */
+static vector<string> makeGraph(int n, const string& family, bool withStart, bool weighted,
+                                int minWeight, int maxWeight, mt19937& rng) {
+    vector<string> args;
+    args.push_back(to_string(n));
+    if (withStart) args.push_back("0");
+
+    auto addEdge = [&](int u, int v) {
+        args.push_back(to_string(u));
+        args.push_back(to_string(v));
+        if (weighted) {
+            args.push_back(to_string(minWeight + (int)(rng() % (maxWeight - minWeight + 1))));
+        }
+    };
+
+    if (family == "grid") {
+        int side = (int)sqrt((double)n);
+        args[0] = to_string(side * side);
+        for (int r = 0; r < side; r++) {
+            for (int c = 0; c < side; c++) {
+                int node = r * side + c;
+                if (c + 1 < side) addEdge(node, node + 1);
+                if (r + 1 < side) addEdge(node, node + side);
+            }
+        }
+    } else {
+        long long edges = family == "dense" ? (long long)n * n / 4 : 4LL * n;
+        for (long long e = 0; e < edges; e++) {
+            int u = (int)(rng() % n), v = (int)(rng() % n);
+            if (family == "dag" || family == "looped") {
+                if (u == v) continue;
+                if (u > v) swap(u, v);
+            }
+            addEdge(u, v);
+        }
+        if (family == "looped") {
+            for (int u = 0; u < n; u += 4) {
+                args.push_back(to_string(u));
+                args.push_back(to_string(u));
+                args.push_back(to_string((int)(rng() % (maxWeight + 1))));
+            }
+        }
+    }
+    return args;
+}
+
+static void addSortCases(vector<BenchCase>& cases, const string& label, int (*run)(int, char**),
+                         vector<string> flags, const vector<int>& sizes) {
+    for (const char* family : {"random", "sorted", "reversed", "few_unique"}) {
+        for (int n : sizes) {
+            string f = family;
+            BenchCase c = {label + "/" + f + "/" + to_string(n), run, flags,
+                           [=](mt19937& rng) { return makeArray(n, f, rng); }};
+            cases.push_back(c);
+        }
+    }
+}
+
+static void addGraphCases(vector<BenchCase>& cases, const string& label, int (*run)(int, char**),
+                          vector<string> flags, const vector<string>& families, const vector<int>& sizes,
+                          bool withStart, bool weighted, int minWeight, int maxWeight,
+                          vector<string> reference = vector<string>()) {
+    for (const string& family : families) {
+        for (int n : sizes) {
+            // Dense graphs have n^2 / 4 edges, so they get much smaller sizes
+            int nodes = family == "dense" ? max(8, n / 32) : n;
+            BenchCase c = {label + "/" + family + "/" + to_string(nodes), run, flags,
+                           [=](mt19937& rng) {
+                               return makeGraph(nodes, family, withStart, weighted, minWeight, maxWeight, rng);
+                           },
+                           reference};
+            cases.push_back(c);
+        }
+    }
+}
+
+static vector<BenchCase> allCases(double scale) {
+    auto sizes = [scale](initializer_list<int> base) {
+        vector<int> scaled;
+        for (int n : base) scaled.push_back(max(2, (int)(n * scale)));
+        return scaled;
+    };
+
+    vector<BenchCase> cases;
+    vector<int> quadratic = sizes({250, 500, 1000});
+    addSortCases(cases, "bubble", runBubbleSort, {}, quadratic);
+    addSortCases(cases, "selection", runSelectionSort, {}, quadratic);
+    addSortCases(cases, "insertion", runInsertionSort, {}, quadratic);
+    vector<int> linearithmic = sizes({2000, 8000, 32000});
+    addSortCases(cases, "merge", runMergeSort, {}, linearithmic);
+    addSortCases(cases, "merge+natural", runMergeSort, {"--natural"}, linearithmic);
+    addSortCases(cases, "merge+parallel", runMergeSort, {"--parallel"}, linearithmic);
+    addSortCases(cases, "pdqsort", runPdqSort, {}, linearithmic);
+    addSortCases(cases, "radix", runRadixSort, {}, linearithmic);
+
+    vector<string> graphs = {"sparse", "grid", "dense"};
+    vector<int> traversal = sizes({256, 1024, 4096});
+    addGraphCases(cases, "bfs", runBFS, {}, graphs, traversal, true, false, 1, 1);
+    addGraphCases(cases, "bfs+direction", runBFS, {"--direction-optimizing"}, graphs, traversal, true, false, 1, 1);
+    addGraphCases(cases, "dfs", runDFS, {}, graphs, traversal, true, false, 1, 1);
+    addGraphCases(cases, "dijkstra", runDijkstra, {}, graphs, traversal, true, true, 1, 100);
+    addGraphCases(cases, "dijkstra+dary", runDijkstra, {"--heap=dary"}, graphs, traversal, true, true, 1, 100);
+    addGraphCases(cases, "dijkstra+radix", runDijkstra, {"--heap=radix"}, graphs, traversal, true, true, 1, 100);
+    addGraphCases(cases, "dijkstra+delta", runDijkstra, {"--delta-stepping"}, graphs, traversal, true, true, 1, 100);
+
+    vector<int> relaxation = sizes({250, 500, 1000});
+    addGraphCases(cases, "bellman_ford", runBellmanFord, {}, {"dag"}, relaxation, true, true, -10, 50);
+    addGraphCases(cases, "bellman_ford+early", runBellmanFord, {"--early-exit"}, {"dag"}, relaxation, true, true, -10, 50);
+    addGraphCases(cases, "bellman_ford+spfa", runBellmanFord, {"--spfa"}, {"dag"}, relaxation, true, true, -10, 50);
+    addGraphCases(cases, "bellman_ford+parallel", runBellmanFord, {"--parallel"}, {"dag"}, relaxation, true, true, -10, 50);
+
+    // Sizes are multiplied by 32 so the dense family lands on 32..128 nodes
+    vector<int> cubic = sizes({1024, 2048, 4096});
+    addGraphCases(cases, "floyd_warshall", runFloydWarshall, {}, {"dense"}, cubic, false, true, 1, 100);
+    addGraphCases(cases, "floyd_warshall", runFloydWarshall, {}, {"dag"}, sizes({64, 128, 256}), false, true,
+                  -10000, 10000);
+    addGraphCases(cases, "floyd_warshall+blocked", runFloydWarshall, {"--blocked"}, {"dense"}, cubic, false, true, 1, 100);
+    addGraphCases(cases, "floyd_warshall+johnson", runFloydWarshall, {"--johnson"}, {"dag", "looped"}, relaxation, false,
+                  true, -10, 50, {"--blocked"});
+    return cases;
+}
+
+static Result runCase(const BenchCase& bench, const vector<string>& input, bool trace, int repeat,
+                      string* output) {
+    Result result = {bench.name, trace ? "on" : "off", 0, 0, 0};
+    for (int r = 0; r < repeat; r++) {
+        vector<string> args;
+        args.push_back(bench.name);
+        args.insert(args.end(), bench.flags.begin(), bench.flags.end());
+        if (!trace) args.push_back("--verbosity=result");
+        args.insert(args.end(), input.begin(), input.end());
+
+        vector<char*> argv;
+        for (string& arg : args) {
+            argv.push_back(&arg[0]);
+        }
+        argv.push_back(nullptr);
+
+        CountingStreamBuf sink;
+        if (r == 0) sink.kept = output;
+        streambuf* previous = cout.rdbuf(&sink);
+        auto start = chrono::steady_clock::now();
+        bench.run((int)args.size(), argv.data());
+        stepWriter().flush();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        cout.rdbuf(previous);
+
+        if (r == 0 || elapsed.count() < result.milliseconds) {
+            result.milliseconds = elapsed.count();
+        }
+        result.steps = sink.lines;
+        result.bytes = sink.bytes;
+    }
+    return result;
+}
+
+static void writeResults(ostream& out, const vector<Result>& results) {
+    out << "case,trace,ms,steps,bytes\n";
+    for (const Result& r : results) {
+        out << r.name << "," << r.trace << "," << fixed << setprecision(3) << r.milliseconds
+            << "," << r.steps << "," << r.bytes << "\n";
+    }
+}
+
+/**
+ * Compare with a baseline file; prints one line per case that moved by
+ * more than the tolerance and returns the number of regressions.
+ */
+static int compareBaseline(const string& path, const vector<Result>& results, double tolerance) {
+    ifstream in(path.c_str());
+    if (!in) {
+        cerr << "Cannot read baseline " << path << endl;
+        return -1;
+    }
+    map<string, double> baseline;
+    string line;
+    getline(in, line);  // Header
+    while (getline(in, line)) {
+        stringstream fields(line);
+        string name, trace, ms;
+        if (getline(fields, name, ',') && getline(fields, trace, ',') && getline(fields, ms, ',')) {
+            baseline[name + "," + trace] = atof(ms.c_str());
+        }
+    }
+
+    int regressions = 0, compared = 0;
+    for (const Result& r : results) {
+        map<string, double>::const_iterator it = baseline.find(r.name + "," + r.trace);
+        if (it == baseline.end() || it->second < 1.0) continue;
+        compared++;
+        double change = (r.milliseconds - it->second) / it->second * 100;
+        if (fabs(change) <= tolerance) continue;
+        bool slower = change > 0;
+        if (slower) regressions++;
+        cerr << (slower ? "REGRESSION  " : "improvement ") << r.name << " trace " << r.trace << ": "
+             << fixed << setprecision(2) << it->second << " ms -> " << r.milliseconds << " ms ("
+             << showpos << setprecision(1) << change << noshowpos << "%)" << endl;
+    }
+    cerr << compared << " cases compared, " << regressions << " regressions over "
+         << tolerance << "%" << endl;
+    return regressions;
+}
+
+// Step type of an NDJSON trace line
+static string stepType(const string& line) {
+    static const string prefix = "{\"type\":\"";
+    if (line.compare(0, prefix.size(), prefix) != 0) return "";
+    return line.substr(prefix.size(), line.find('"', prefix.size()) - prefix.size());
+}
+
+/**
+ * --check for one case: the expected trace (a full trace, or another
+ * mode's) filtered to the result-level step types must equal the
+ * --verbosity=result trace line for line. Levels come from the
+ * declarations of the run that just finished.
+ */
+static bool sameResults(const string& name, const string& label, const string& full, const string& result) {
+    stringstream fullLines(full), resultLines(result);
+    string expected, actual;
+    long long line = 0;
+    while (true) {
+        bool more = false;
+        while (getline(fullLines, expected)) {
+            if (stepWriter().levelOf(stepType(expected).c_str()) == TRACE_RESULT) {
+                more = true;
+                break;
+            }
+        }
+        bool moreActual = (bool)getline(resultLines, actual);
+        if (!more && !moreActual) return true;
+        line++;
+        if (!more || !moreActual || expected != actual) {
+            cerr << "MISMATCH    " << name << " result step " << line << ": " << label << " has "
+                 << (more ? expected : "nothing") << ", --verbosity=result has "
+                 << (moreActual ? actual : "nothing") << endl;
+            return false;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    double scale = atof(opts.get("scale", "1").c_str());
+    int repeat = (int)max(1LL, opts.getInt("repeat", 3));
+    string filter = opts.get("filter");
+    double tolerance = atof(opts.get("tolerance", "10").c_str());
+    bool check = opts.has("check");
+
+    vector<Result> results;
+    int mismatches = 0;
+    for (const BenchCase& bench : allCases(scale > 0 ? scale : 1)) {
+        if (!filter.empty() && bench.name.find(filter) == string::npos) continue;
+
+        mt19937 rng(seedFor(bench.name));
+        vector<string> input = bench.input(rng);
+        string outputs[2];
+        for (bool trace : {true, false}) {
+            Result result = runCase(bench, input, trace, repeat, check ? &outputs[trace ? 0 : 1] : nullptr);
+            cerr << left << setw(44) << result.name << " trace " << setw(4) << result.trace << right
+                 << setw(12) << fixed << setprecision(2) << result.milliseconds << " ms"
+                 << setw(12) << result.steps << " steps" << endl;
+            results.push_back(result);
+        }
+        if (check && !sameResults(bench.name, "full trace", outputs[0], outputs[1])) {
+            mismatches++;
+        }
+        if (check && !bench.reference.empty()) {
+            BenchCase reference = bench;
+            reference.flags = bench.reference;
+            string expected;
+            runCase(reference, input, false, 1, &expected);
+            string label = "";
+            for (const string& flag : bench.reference) label += (label.empty() ? "" : " ") + flag;
+            if (!sameResults(bench.name, label, expected, outputs[1])) {
+                mismatches++;
+            }
+        }
+    }
+
+    if (opts.has("out")) {
+        ofstream out(opts.get("out").c_str());
+        writeResults(out, results);
+    } else {
+        writeResults(cout, results);
+    }
+
+    if (opts.has("baseline")) {
+        int regressions = compareBaseline(opts.get("baseline"), results, tolerance);
+        if (regressions != 0) return 1;
+    }
+    if (check) {
+        cerr << mismatches << " cases failed --check" << endl;
+        if (mismatches != 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+#include "../csr_graph.h"
+#include "../graph_input.h"
+#include "../priority_queues.h"
+
+using namespace std;
+
+/**
+ * Dijkstra Priority Queue Benchmark
+ * Runs Dijkstra without tracing using each queue from priority_queues.h
+ * on three graph families and reports the time per run and the peak
+ * number of queued entries:
+ *   sparse   random graph, 4 edges per node
+ *   grid     square 2D grid, 4-neighborhood
+ *   dense    random graph, 25% of all node pairs
+ * Weights are uniform in [1, 100].
+ *
+ * Usage: dijkstra_heap_bench [scale]   (scale 1 = ~1M arcs per family)
+ */
+
+struct Result {
+    double milliseconds;
+    size_t peakEntries;
+    long long checksum;
+};
+
+template <typename Queue>
+static Result runDijkstra(const CsrGraph& graph, int source) {
+    auto start = chrono::steady_clock::now();
+    vector<int> dist(graph.numNodes, INT_MAX);
+    vector<bool> visited(graph.numNodes, false);
+    Queue pq(graph.numNodes);
+    size_t peak = 1;
+
+    dist[source] = 0;
+    pq.push(source, 0);
+    while (!pq.empty()) {
+        int u, d;
+        pq.popMin(u, d);
+        if (visited[u]) continue;
+        visited[u] = true;
+        for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+            int v = graph.targets[a];
+            int candidate = d + graph.weights[a];
+            if (!visited[v] && candidate < dist[v]) {
+                dist[v] = candidate;
+                pq.push(v, candidate);
+            }
+        }
+        peak = max(peak, pq.size());
+    }
+
+    Result result;
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    result.milliseconds = elapsed.count();
+    result.peakEntries = peak;
+    result.checksum = 0;
+    for (int d : dist) {
+        if (d != INT_MAX) result.checksum += d;
+    }
+    return result;
+}
+
+static void addEdge(GraphInput& input, int u, int v, mt19937& rng) {
+    input.edges.u.push_back(u);
+    input.edges.v.push_back(v);
+    input.edges.w.push_back((int)(rng() % 100) + 1);
+}
+
+static void makeRandom(GraphInput& input, int nodes, long long edges, mt19937& rng) {
+    input.numNodes = nodes;
+    for (long long e = 0; e < edges; e++) {
+        addEdge(input, (int)(rng() % nodes), (int)(rng() % nodes), rng);
+    }
+}
+
+static void makeGrid(GraphInput& input, int side, mt19937& rng) {
+    input.numNodes = side * side;
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            int node = r * side + c;
+            if (c + 1 < side) addEdge(input, node, node + 1, rng);
+            if (r + 1 < side) addEdge(input, node, node + side, rng);
+        }
+    }
+}
+
+static void report(const char* family, const char* heap, const Result& result) {
+    cerr << left << setw(8) << family << setw(10) << heap << right
+         << setw(10) << fixed << setprecision(2) << result.milliseconds << " ms"
+         << setw(12) << result.peakEntries << " peak entries"
+         << "   checksum " << result.checksum << endl;
+}
+
+static void benchFamily(const char* family, const GraphInput& input) {
+    CsrGraph graph;
+    graph.build(input, CSR_UNDIRECTED | CSR_WEIGHTED);
+    report(family, "binary", runDijkstra<LazyBinaryHeap>(graph, 0));
+    report(family, "dary-2", runDijkstra<IndexedDaryHeap<2>>(graph, 0));
+    report(family, "dary-4", runDijkstra<IndexedDaryHeap<4>>(graph, 0));
+    report(family, "dary-8", runDijkstra<IndexedDaryHeap<8>>(graph, 0));
+    report(family, "radix", runDijkstra<RadixHeap>(graph, 0));
+}
+
+int main(int argc, char* argv[]) {
+    double scale = argc > 1 ? atof(argv[1]) : 1.0;
+    mt19937 rng(12345);
+
+    {
+        GraphInput input;
+        int nodes = (int)(125000 * scale);
+        makeRandom(input, nodes, 4LL * nodes, rng);
+        benchFamily("sparse", input);
+    }
+    {
+        GraphInput input;
+        int side = (int)(350 * sqrt(scale));
+        makeGrid(input, side, rng);
+        benchFamily("grid", input);
+    }
+    {
+        GraphInput input;
+        int nodes = (int)(2000 * sqrt(scale));
+        makeRandom(input, nodes, (long long)nodes * nodes / 8, rng);
+        benchFamily("dense", input);
+    }
+    return 0;
+}
+
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "../step_writer.h"
+
+using namespace std;
+
+/**
+ * Step Writer Microbenchmark
+ * Emits the same bubble-sort-style trace with the old per-step
+ * `cout << ... << endl` emitter and with StepWriter, and reports
+ * lines per second for each.
+ *
+ * Usage: step_writer_bench [num_lines] > /dev/null
+ * Results are printed to stderr so stdout can be discarded.
+ */
+
+static void legacyStep(const string& type, int i, int j = -1, int value = -1) {
+    cout << "{";
+    cout << "\"type\":\"" << type << "\"";
+    cout << ",\"i\":" << i;
+    if (j != -1) {
+        cout << ",\"j\":" << j;
+    }
+    if (value != -1) {
+        cout << ",\"value\":" << value;
+    }
+    cout << "}" << endl;
+}
+
+static void bufferedStep(const char* type, int i, int j = -1, int value = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
+    out.field("i", i);
+    if (j != -1) {
+        out.field("j", j);
+    }
+    if (value != -1) {
+        out.field("value", value);
+    }
+    out.endStep();
+}
+
+template <typename Emit>
+static double linesPerSecond(long long lines, Emit emit) {
+    auto start = chrono::steady_clock::now();
+    for (long long n = 0; n < lines; n++) {
+        int j = (int)(n % 2000);
+        if (n % 3 == 0) {
+            emit("swap", j, j + 1, -1);
+        } else {
+            emit("compare", j, j + 1, -1);
+        }
+    }
+    stepWriter().flush();
+    cout.flush();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return lines / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    long long lines = argc > 1 ? atoll(argv[1]) : 2000000;
+
+    double legacy = linesPerSecond(lines, [](const char* type, int i, int j, int value) {
+        legacyStep(type, i, j, value);
+    });
+    double buffered = linesPerSecond(lines, [](const char* type, int i, int j, int value) {
+        bufferedStep(type, i, j, value);
+    });
+
+    cerr << "lines:            " << lines << endl;
+    cerr << "cout + endl:      " << (long long)legacy << " lines/s" << endl;
+    cerr << "StepWriter:       " << (long long)buffered << " lines/s" << endl;
+    cerr << "speedup:          " << buffered / legacy << "x" << endl;
+    return 0;
+}
+
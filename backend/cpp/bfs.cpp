@@ -1,73 +1,373 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <climits>
+#include <atomic>
+#include <algorithm>
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
 
+#include "algorithms.h"
+#include "csr_graph.h"
+#include "frontier_deltas.h"
+#include "graph_input.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "parallel.h"
+#include "step_writer.h"
+
 using namespace std;
 
 /**
  * Breadth-First Search (BFS)
  * Input format: <num_nodes> <start_node> <edge1_u> <edge1_v> <edge2_u> <edge2_v> ...
+ * (edges may instead come from --stdin or a --graph=<file> CSR file, see graph_input.h)
  * Outputs JSON steps for visualization:
  * - visit(node): Visiting a node
  * - enqueue(node): Adding node to queue
  * - dequeue(node): Removing node from queue
  * - explore(u, v): Exploring edge from u to v
+ * With --queue-deltas the queue is traced as queue_push/queue_pop steps
+ * plus occasional full snapshots (see frontier_deltas.h).
+ * --direction-optimizing runs a level-synchronous, multithreaded BFS
+ * (--threads=<n>, see directionOptimizingBFS) with the same visit order,
+ * parents and trace as the queue BFS.
  */
 
-void outputStep(const string& type, int node1 = -1, int node2 = -1, const string& extra = "") {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
+static void outputStep(const char* type, int node1 = -1, int node2 = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
     if (node1 != -1) {
-        cout << ",\"node\":" << node1;
+        out.field("node", node1);
     }
     if (node2 != -1) {
-        cout << ",\"target\":" << node2;
+        out.field("target", node2);
     }
-    if (!extra.empty()) {
-        cout << "," << extra;
+    out.endStep();
+}
+
+static void outputQueue(const queue<int>& q) {
+    StepWriter& out = stepWriter();
+    if (!out.emits(TRACE_FULL)) return;
+    out.beginStep("queue");
+    out.beginList("queue");
+    queue<int> temp = q;
+    while (!temp.empty()) {
+        out.item(temp.front());
+        temp.pop();
     }
-    cout << "}" << endl;
+    out.endList();
+    out.endStep();
 }
 
-void outputQueue(const queue<int>& q) {
-    cout << "{";
-    cout << "\"type\":\"queue\",\"queue\":[";
+// The queue of the level-synchronous search while frontier[j] is next in
+// line: the rest of the frontier, then the first `found` nodes of the next level
+static void listLevelQueue(const char* key, const vector<int>& frontier, size_t j, const vector<int>& next,
+                           size_t found) {
+    StepWriter& out = stepWriter();
+    out.beginList(key);
+    for (size_t i = j; i < frontier.size(); i++) {
+        out.item(frontier[i]);
+    }
+    for (size_t i = 0; i < found; i++) {
+        out.item(next[i]);
+    }
+    out.endList();
+}
+
+static void outputLevelQueue(const vector<int>& frontier, size_t j, const vector<int>& next, size_t found) {
+    StepWriter& out = stepWriter();
+    if (!out.emits(TRACE_FULL)) return;
+    out.beginStep("queue");
+    listLevelQueue("queue", frontier, j, next, found);
+    out.endStep();
+}
+
+static void outputParents(const vector<int>& parent, const vector<bool>& visited) {
+    StepWriter& out = stepWriter();
+    for (size_t i = 0; i < visited.size(); i++) {
+        if (visited[i]) {
+            out.beginStep("parent");
+            out.field("node", (long long)i);
+            out.field("parent", parent[i]);
+            out.endStep();
+        }
+    }
+}
+
+// Keyframe: the nodes marked visited (enqueued so far) and the queue
+static void outputKeyframe(Keyframes& keyframes, const vector<bool>& visited, const queue<int>& q) {
+    StepWriter& out = stepWriter();
+    keyframes.begin();
+    keyframes.marked("visited", visited);
+    out.beginList("frontier");
     queue<int> temp = q;
-    bool first = true;
     while (!temp.empty()) {
-        if (!first) cout << ",";
-        cout << temp.front();
+        out.item(temp.front());
         temp.pop();
-        first = false;
     }
-    cout << "]}" << endl;
+    out.endList();
+    keyframes.end();
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 4) {
+static const size_t BFS_GRAIN = 1024;
+static const int64_t ALPHA = 14;    // Go bottom-up when frontier arcs > unexplored arcs / ALPHA
+static const int64_t BETA = 24;     // Go back top-down when frontier nodes < numNodes / BETA
+
+/**
+ * Trace one level of the level-synchronous search exactly as the queue
+ * BFS would dequeue it. next holds the next level in discovery order,
+ * with the nodes discovered by frontier[j] at next[offsets[j]..offsets[j + 1]).
+ * enqueued (kept only for keyframes) marks the nodes queued so far.
+ */
+static void traceLevel(const CsrGraph& graph, const vector<int>& frontier, const vector<int>& next,
+                       const vector<int>& offsets, FrontierDeltas& deltas, Keyframes& keyframes,
+                       vector<bool>& enqueued) {
+    StepWriter& out = stepWriter();
+    bool events = out.emits(TRACE_EVENTS) || deltas.enabled || keyframes.enabled;
+    for (size_t j = 0; j < frontier.size(); j++) {
+        int u = frontier[j];
+        if (keyframes.due()) {
+            keyframes.begin();
+            keyframes.marked("visited", enqueued);
+            listLevelQueue("frontier", frontier, j, next, offsets[j]);
+            keyframes.end();
+        }
+        outputStep("dequeue", u);
+        if (deltas.enabled) {
+            deltas.pop(u);
+        }
+        outputStep("visit", u);
+        if (!events) continue;
+
+        // A node's first arc from its discoverer is where the queue BFS enqueued it
+        int k = offsets[j];
+        bool explore = out.emits(TRACE_FULL);
+        for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u) && (explore || k < offsets[j + 1]); a++) {
+            int v = graph.targets[a];
+            outputStep("explore", u, v);
+            if (k < offsets[j + 1] && v == next[k]) {
+                k++;
+                if (keyframes.enabled) enqueued[v] = true;
+                outputStep("enqueue", v);
+                if (deltas.enabled) {
+                    deltas.push(v);
+                }
+            }
+        }
+
+        size_t queued = frontier.size() - j - 1 + offsets[j + 1];
+        if (deltas.enabled) {
+            if (deltas.snapshotDue(queued)) {
+                outputLevelQueue(frontier, j + 1, next, offsets[j + 1]);
+            }
+        } else if (queued > 0) {
+            outputLevelQueue(frontier, j + 1, next, offsets[j + 1]);
+        }
+    }
+}
+
+/**
+ * Direction-optimizing BFS over bitmaps. A level is expanded top-down
+ * (frontier nodes scan their neighbors) while the frontier is small, and
+ * bottom-up (every unvisited node scans its own neighbors for frontier
+ * nodes) once the frontier's arcs outweigh the unexplored ones. Both
+ * directions run on the worker pool; bottom-up assumes the arcs are
+ * symmetric, as they are for the undirected graphs built here.
+ *
+ * Each new node is claimed by its neighbor earliest in the frontier (an
+ * atomic min top-down, a scan of all its neighbors bottom-up), which is
+ * the node the queue BFS discovers it from. A second pass has every
+ * frontier node write the nodes it claimed, in arc order, at its offset in
+ * the next level. Levels, parents and the trace (see traceLevel) are
+ * therefore those of the queue BFS, for any thread count and direction.
+ */
+static void directionOptimizingBFS(const CsrGraph& graph, int startNode, WorkerPool& pool, FrontierDeltas& deltas,
+                                   Keyframes& keyframes) {
+    int numNodes = graph.numNodes;
+    size_t words = ((size_t)numNodes + 63) / 64;
+    vector<atomic<uint64_t>> visited(words);
+    vector<uint64_t> frontierBits(words, 0);
+    for (size_t w = 0; w < words; w++) {
+        visited[w].store(0, memory_order_relaxed);
+    }
+    vector<atomic<int>> claim(numNodes);   // Frontier index of the discoverer
+    for (int v = 0; v < numNodes; v++) {
+        claim[v].store(INT_MAX, memory_order_relaxed);
+    }
+    vector<int> position(numNodes, -1);     // Index of each node in the current frontier
+    vector<int> level(numNodes, -1);
+    vector<int> parent(numNodes, -1);
+    vector<vector<int>> found(pool.size());
+    vector<bool> enqueued(keyframes.enabled ? numNodes : 0, false);
+
+    vector<int> frontier(1, startNode), next, offsets;
+    visited[startNode / 64].fetch_or(1ULL << (startNode % 64), memory_order_relaxed);
+    level[startNode] = 0;
+    if (keyframes.enabled) enqueued[startNode] = true;
+    outputStep("enqueue", startNode);
+    if (deltas.enabled) {
+        deltas.push(startNode);
+    }
+    outputLevelQueue(frontier, 0, next, 0);
+
+    int64_t unexploredArcs = graph.numArcs;
+    bool bottomUp = false;
+    OpCounters& ops = runMetrics().ops;
+
+    for (int depth = 0; !frontier.empty(); depth++) {
+        int64_t frontierArcs = 0;
+        for (size_t i = 0; i < frontier.size(); i++) {
+            position[frontier[i]] = (int)i;
+            frontierArcs += graph.arcEnd(frontier[i]) - graph.arcBegin(frontier[i]);
+        }
+        unexploredArcs -= frontierArcs;
+
+        if (!bottomUp && frontierArcs > unexploredArcs / ALPHA) {
+            bottomUp = true;
+        } else if (bottomUp && (int64_t)frontier.size() < numNodes / BETA) {
+            bottomUp = false;
+        }
+
+        if (bottomUp) {
+            fill(frontierBits.begin(), frontierBits.end(), 0);
+            for (int u : frontier) {
+                frontierBits[u / 64] |= 1ULL << (u % 64);
+            }
+            // Each task owns whole bitmap words, so plain stores suffice
+            pool.parallelFor(words, BFS_GRAIN / 64, [&](size_t begin, size_t end, int worker) {
+                long long examined = 0;
+                for (size_t w = begin; w < end; w++) {
+                    uint64_t seen = visited[w].load(memory_order_relaxed);
+                    uint64_t added = 0;
+                    int last = (int)min((size_t)numNodes, (w + 1) * 64);
+                    for (int v = (int)(w * 64); v < last; v++) {
+                        if (seen & (1ULL << (v % 64))) continue;
+                        int best = INT_MAX;
+                        for (int u : graph.neighbors(v)) {
+                            examined++;
+                            if (frontierBits[u / 64] & (1ULL << (u % 64))) {
+                                best = min(best, position[u]);
+                            }
+                        }
+                        if (best != INT_MAX) {
+                            added |= 1ULL << (v % 64);
+                            claim[v].store(best, memory_order_relaxed);
+                            found[worker].push_back(v);
+                        }
+                    }
+                    visited[w].store(seen | added, memory_order_relaxed);
+                }
+                Metrics::countShared(ops.relaxations, examined);
+            });
+        } else {
+            ops.relaxations += frontierArcs;
+            pool.parallelFor(frontier.size(), BFS_GRAIN, [&](size_t begin, size_t end, int worker) {
+                for (size_t i = begin; i < end; i++) {
+                    for (int v : graph.neighbors(frontier[i])) {
+                        if (visited[v / 64].load(memory_order_relaxed) & (1ULL << (v % 64))) continue;
+                        int current = claim[v].load(memory_order_relaxed);
+                        while ((int)i < current) {
+                            if (claim[v].compare_exchange_weak(current, (int)i, memory_order_relaxed)) {
+                                if (current == INT_MAX) found[worker].push_back(v);
+                                break;
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        // Slots of each frontier node's discoveries in the next level
+        offsets.assign(frontier.size() + 1, 0);
+        for (vector<int>& nodes : found) {
+            for (int v : nodes) {
+                offsets[claim[v].load(memory_order_relaxed) + 1]++;
+            }
+            nodes.clear();
+        }
+        for (size_t i = 0; i < frontier.size(); i++) {
+            offsets[i + 1] += offsets[i];
+        }
+        next.resize(offsets[frontier.size()]);
+
+        // Only the claiming frontier node writes a new node's entries
+        pool.parallelFor(frontier.size(), BFS_GRAIN, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+                int u = frontier[i];
+                int k = offsets[i];
+                for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u) && k < offsets[i + 1]; a++) {
+                    int v = graph.targets[a];
+                    if (claim[v].load(memory_order_relaxed) != (int)i || level[v] != -1) continue;
+                    level[v] = depth + 1;
+                    parent[v] = u;
+                    next[k++] = v;
+                    visited[v / 64].fetch_or(1ULL << (v % 64), memory_order_relaxed);
+                }
+            }
+        });
+
+        ops.pops += frontier.size();
+        ops.pushes += next.size();
+        traceLevel(graph, frontier, next, offsets, deltas, keyframes, enqueued);
+        frontier.swap(next);
+    }
+
+    // Output empty queue at the end
+    outputLevelQueue(frontier, 0, next, 0);
+
+    runMetrics().phase(PHASE_EMIT);
+    vector<bool> reached(numNodes);
+    for (int v = 0; v < numNodes; v++) {
+        reached[v] = level[v] >= 0;
+    }
+    outputParents(parent, reached);
+}
+
+int runBFS(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
+    if (argc < 3) {
         cerr << "Usage: " << argv[0] << " <num_nodes> <start_node> <edge1_u> <edge1_v> ..." << endl;
         return 1;
     }
 
-    int numNodes = atoi(argv[1]);
+    GraphInput input;
+    if (!loadGraph(opts, argc, argv, 3, false, input)) {
+        return 1;
+    }
     int startNode = atoi(argv[2]);
+    if (startNode < 0 || startNode >= input.numNodes) {
+        cerr << "start_node " << startNode << " is not a node" << endl;
+        return 1;
+    }
+
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"enqueue", "dequeue"}, "node target", TRACE_EVENTS);
+    out.declareSteps({"visit"}, "node target", TRACE_RESULT);
+    out.declareSteps({"explore"}, "node target");
+    out.declareSteps({"queue"}, "queue[]");
+    out.declareSteps({"parent"}, "node parent", TRACE_RESULT);
+    FrontierDeltas deltas(opts, FrontierDeltas::QUEUE);
+    Keyframes keyframes(opts);
+
+    int numNodes = input.numNodes;
     
-    vector<vector<int>> graph(numNodes);
-    
-    // Parse edges
-    for (int i = 3; i < argc; i += 2) {
-        if (i + 1 < argc) {
-            int u = atoi(argv[i]);
-            int v = atoi(argv[i + 1]);
-            if (u >= 0 && u < numNodes && v >= 0 && v < numNodes) {
-                graph[u].push_back(v);
-                graph[v].push_back(u); // Undirected graph
-            }
-        }
+    metrics.phase(PHASE_BUILD);
+    CsrGraph graph;
+    graph.build(input, CSR_UNDIRECTED); // Undirected graph
+    metrics.phase(PHASE_RUN);
+
+    if (opts.has("direction-optimizing")) {
+        WorkerPool pool(threadCount(opts));
+        directionOptimizingBFS(graph, startNode, pool, deltas, keyframes);
+        finishMetrics();
+        return 0;
     }
+    OpCounters& ops = metrics.ops;
 
     vector<bool> visited(numNodes, false);
     vector<int> parent(numNodes, -1);
@@ -75,31 +375,51 @@ int main(int argc, char* argv[]) {
     
     // Start BFS
     q.push(startNode);
+    ops.pushes++;
     visited[startNode] = true;
     parent[startNode] = -1; // Start node has no parent
     outputStep("enqueue", startNode);
+    if (deltas.enabled) {
+        deltas.push(startNode);
+    }
     outputQueue(q);
     
     while (!q.empty()) {
+        if (keyframes.due()) {
+            outputKeyframe(keyframes, visited, q);
+        }
         int current = q.front();
         q.pop();
+        ops.pops++;
         
         outputStep("dequeue", current);
+        if (deltas.enabled) {
+            deltas.pop(current);
+        }
         outputStep("visit", current);
         
         // Explore neighbors
-        for (int neighbor : graph[current]) {
+        for (int neighbor : graph.neighbors(current)) {
             outputStep("explore", current, neighbor);
+            ops.relaxations++;
             
             if (!visited[neighbor]) {
                 visited[neighbor] = true;
                 parent[neighbor] = current; // Track parent for path reconstruction
                 q.push(neighbor);
+                ops.pushes++;
                 outputStep("enqueue", neighbor);
+                if (deltas.enabled) {
+                    deltas.push(neighbor);
+                }
             }
         }
         
-        if (!q.empty()) {
+        if (deltas.enabled) {
+            if (deltas.snapshotDue(q.size())) {
+                outputQueue(q);
+            }
+        } else if (!q.empty()) {
             outputQueue(q);
         }
     }
@@ -108,14 +428,16 @@ int main(int argc, char* argv[]) {
     outputQueue(q);
     
     // Output parent information for path reconstruction
-    for (int i = 0; i < numNodes; i++) {
-        if (visited[i]) {
-            cout << "{";
-            cout << "\"type\":\"parent\",\"node\":" << i << ",\"parent\":" << parent[i];
-            cout << "}" << endl;
-        }
-    }
+    metrics.phase(PHASE_EMIT);
+    outputParents(parent, visited);
+    finishMetrics();
 
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runBFS(argc, argv);
+}
+#endif
+
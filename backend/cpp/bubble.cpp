@@ -3,6 +3,12 @@
 #include <sstream>
 #include <cstdlib>
 
+#include "algorithms.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "step_writer.h"
+
 using namespace std;
 
 /**
@@ -13,25 +19,34 @@ using namespace std;
  * - sorted(i): Element at index i is in final sorted position
  */
 
-void outputStep(const string& type, int i, int j = -1, int value = -1) {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
-    cout << ",\"i\":" << i;
+static void outputStep(const char* type, int i, int j = -1, int value = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
+    out.field("i", i);
     if (j != -1) {
-        cout << ",\"j\":" << j;
+        out.field("j", j);
     }
     if (value != -1) {
-        cout << ",\"value\":" << value;
+        out.field("value", value);
     }
-    cout << "}" << endl;
+    out.endStep();
 }
 
-int main(int argc, char* argv[]) {
+int runBubbleSort(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
     if (argc < 2) {
         cerr << "Usage: " << argv[0] << " <numbers>" << endl;
         return 1;
     }
 
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"compare"}, "i j value");
+    out.declareSteps({"swap"}, "i j value", TRACE_EVENTS);
+    out.declareSteps({"sorted"}, "i j value", TRACE_RESULT);
+    Keyframes keyframes(opts);
+
     vector<int> arr;
     
     // Parse command line arguments
@@ -40,20 +55,33 @@ int main(int argc, char* argv[]) {
     }
 
     int n = arr.size();
+    OpCounters& ops = metrics.ops;
+    metrics.phase(PHASE_RUN);
     
     // Bubble Sort
     for (int i = 0; i < n - 1; i++) {
         bool swapped = false;
         for (int j = 0; j < n - i - 1; j++) {
             // Compare step
-            outputStep("compare", j, j + 1);
+            if (out.emits(TRACE_FULL)) {
+                outputStep("compare", j, j + 1);
+            }
+            ops.comparisons++;
             
             if (arr[j] > arr[j + 1]) {
                 // Swap step
-                outputStep("swap", j, j + 1);
+                if (out.emits(TRACE_EVENTS)) {
+                    outputStep("swap", j, j + 1);
+                }
                 swap(arr[j], arr[j + 1]);
+                ops.swaps++;
                 swapped = true;
             }
+            if (keyframes.due()) {
+                keyframes.begin();
+                keyframes.list("array", arr);
+                keyframes.end();
+            }
         }
         
         // Mark the last element as sorted
@@ -73,6 +101,15 @@ int main(int argc, char* argv[]) {
         outputStep("sorted", 0);
     }
 
+    metrics.phase(PHASE_EMIT);
+    finishMetrics();
+
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runBubbleSort(argc, argv);
+}
+#endif
+
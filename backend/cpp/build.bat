@@ -4,31 +4,53 @@ REM Build script for Windows to compile C++ algorithms
 if not exist build mkdir build
 
 echo Compiling bubble sort...
-g++ -o build/bubble.exe bubble.cpp -std=c++11
+g++ -O2 -o build/bubble.exe bubble.cpp -std=c++11
 
 echo Compiling selection sort...
-g++ -o build/selection.exe selection.cpp -std=c++11
+g++ -O2 -o build/selection.exe selection.cpp -std=c++11
 
 echo Compiling insertion sort...
-g++ -o build/insertion.exe insertion.cpp -std=c++11
+g++ -O2 -o build/insertion.exe insertion.cpp -std=c++11
 
 echo Compiling merge sort...
-g++ -o build/merge.exe merge.cpp -std=c++11
+g++ -O2 -o build/merge.exe merge.cpp -std=c++11 -pthread
+
+echo Compiling pdqsort...
+g++ -O2 -o build/pdqsort.exe pdqsort.cpp -std=c++11
+
+echo Compiling radix sort...
+g++ -O2 -o build/radix.exe radix.cpp -std=c++11
 
 echo Compiling BFS...
-g++ -o build/bfs.exe bfs.cpp -std=c++11
+g++ -O2 -o build/bfs.exe bfs.cpp -std=c++11 -pthread
 
 echo Compiling DFS...
-g++ -o build/dfs.exe dfs.cpp -std=c++11
+g++ -O2 -o build/dfs.exe dfs.cpp -std=c++11
 
 echo Compiling Dijkstra...
-g++ -o build/dijkstra.exe dijkstra.cpp -std=c++11
+g++ -O2 -o build/dijkstra.exe dijkstra.cpp -std=c++11 -pthread
 
 echo Compiling Bellman-Ford...
-g++ -o build/bellman_ford.exe bellman_ford.cpp -std=c++11
+g++ -O2 -o build/bellman_ford.exe bellman_ford.cpp -std=c++11 -pthread
 
 echo Compiling Floyd-Warshall...
-g++ -o build/floyd_warshall.exe floyd_warshall.cpp -std=c++11
+g++ -O2 -o build/floyd_warshall.exe floyd_warshall.cpp -std=c++11 -pthread
+
+echo Compiling CSR graph converter...
+g++ -O2 -o build/csr_convert.exe csr_convert.cpp -std=c++11
+
+echo Compiling engine (all algorithms in one process)...
+g++ -O2 -o build/engine.exe engine.cpp bubble.cpp selection.cpp insertion.cpp merge.cpp pdqsort.cpp radix.cpp ^
+    bfs.cpp dfs.cpp dijkstra.cpp bellman_ford.cpp floyd_warshall.cpp -std=c++11 -pthread -DALGO_ENGINE
+
+if "%1"=="bench" (
+    echo Compiling benchmarks...
+    g++ -O2 -o build/step_writer_bench.exe bench/step_writer_bench.cpp -std=c++11
+    g++ -O2 -o build/dijkstra_heap_bench.exe bench/dijkstra_heap_bench.cpp -std=c++11
+    g++ -O2 -o build/algorithm_bench.exe bench/algorithm_bench.cpp bubble.cpp selection.cpp insertion.cpp merge.cpp ^
+        pdqsort.cpp radix.cpp ^
+        bfs.cpp dfs.cpp dijkstra.cpp bellman_ford.cpp floyd_warshall.cpp -std=c++11 -pthread -DALGO_ENGINE
+)
 
 echo Build complete!
 
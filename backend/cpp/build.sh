@@ -4,31 +4,53 @@
 mkdir -p build
 
 echo "Compiling bubble sort..."
-g++ -o build/bubble bubble.cpp -std=c++11
+g++ -O2 -o build/bubble bubble.cpp -std=c++11
 
 echo "Compiling selection sort..."
-g++ -o build/selection selection.cpp -std=c++11
+g++ -O2 -o build/selection selection.cpp -std=c++11
 
 echo "Compiling insertion sort..."
-g++ -o build/insertion insertion.cpp -std=c++11
+g++ -O2 -o build/insertion insertion.cpp -std=c++11
 
 echo "Compiling merge sort..."
-g++ -o build/merge merge.cpp -std=c++11
+g++ -O2 -o build/merge merge.cpp -std=c++11 -pthread
+
+echo "Compiling pdqsort..."
+g++ -O2 -o build/pdqsort pdqsort.cpp -std=c++11
+
+echo "Compiling radix sort..."
+g++ -O2 -o build/radix radix.cpp -std=c++11
 
 echo "Compiling BFS..."
-g++ -o build/bfs bfs.cpp -std=c++11
+g++ -O2 -o build/bfs bfs.cpp -std=c++11 -pthread
 
 echo "Compiling DFS..."
-g++ -o build/dfs dfs.cpp -std=c++11
+g++ -O2 -o build/dfs dfs.cpp -std=c++11
 
 echo "Compiling Dijkstra..."
-g++ -o build/dijkstra dijkstra.cpp -std=c++11
+g++ -O2 -o build/dijkstra dijkstra.cpp -std=c++11 -pthread
 
 echo "Compiling Bellman-Ford..."
-g++ -o build/bellman_ford bellman_ford.cpp -std=c++11
+g++ -O2 -o build/bellman_ford bellman_ford.cpp -std=c++11 -pthread
 
 echo "Compiling Floyd-Warshall..."
-g++ -o build/floyd_warshall floyd_warshall.cpp -std=c++11
+g++ -O2 -o build/floyd_warshall floyd_warshall.cpp -std=c++11 -pthread
+
+echo "Compiling CSR graph converter..."
+g++ -O2 -o build/csr_convert csr_convert.cpp -std=c++11
+
+echo "Compiling engine (all algorithms in one process)..."
+g++ -O2 -o build/engine engine.cpp bubble.cpp selection.cpp insertion.cpp merge.cpp pdqsort.cpp radix.cpp \
+    bfs.cpp dfs.cpp dijkstra.cpp bellman_ford.cpp floyd_warshall.cpp -std=c++11 -pthread -DALGO_ENGINE
+
+if [ "$1" == "bench" ]; then
+    echo "Compiling benchmarks..."
+    g++ -O2 -o build/step_writer_bench bench/step_writer_bench.cpp -std=c++11
+    g++ -O2 -o build/dijkstra_heap_bench bench/dijkstra_heap_bench.cpp -std=c++11
+    g++ -O2 -o build/algorithm_bench bench/algorithm_bench.cpp bubble.cpp selection.cpp insertion.cpp merge.cpp \
+        pdqsort.cpp radix.cpp \
+        bfs.cpp dfs.cpp dijkstra.cpp bellman_ford.cpp floyd_warshall.cpp -std=c++11 -pthread -DALGO_ENGINE
+fi
 
 echo "Build complete!"
 chmod +x build/*
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+#include "graph_input.h"
+#include "options.h"
+
+using namespace std;
+
+/**
+ * CSR Converter
+ * Reads a whitespace-separated edge list from stdin and writes the binary
+ * CSR graph file loaded by --graph=<file> (layout in graph_input.h).
+ * Usage: csr_convert [--weighted] [--undirected] <num_nodes> <output_file> < edges.txt
+ *   --weighted     edges are <u> <v> <weight> triples instead of <u> <v> pairs
+ *   --undirected   store every edge in both directions, as BFS, DFS and
+ *                  Dijkstra expect for their undirected graphs
+ * Edges with endpoints outside [0, num_nodes) are dropped.
+ */
+
+static void putUint32(ofstream& out, uint32_t value) {
+    out.write((const char*)&value, sizeof(value));
+}
+
+int main(int argc, char* argv[]) {
+    Options opts(argc, argv);
+
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " [--weighted] [--undirected] <num_nodes> <output_file> < edges" << endl;
+        return 1;
+    }
+
+    bool weighted = opts.has("weighted");
+    bool undirected = opts.has("undirected");
+    int numNodes = atoi(argv[1]);
+    int width = weighted ? 3 : 2;
+
+    vector<int> tokens = readIntTokens(stdin);
+
+    // Counting sort of the arcs by source node
+    vector<int64_t> offsets(numNodes + 1, 0);
+    for (size_t t = 0; t + width <= tokens.size(); t += width) {
+        int u = tokens[t], v = tokens[t + 1];
+        if (u < 0 || u >= numNodes || v < 0 || v >= numNodes) continue;
+        offsets[u + 1]++;
+        if (undirected) offsets[v + 1]++;
+    }
+    for (int u = 0; u < numNodes; u++) {
+        offsets[u + 1] += offsets[u];
+    }
+
+    int64_t numArcs = offsets[numNodes];
+    vector<int32_t> targets(numArcs);
+    vector<int32_t> weights(weighted ? numArcs : 0);
+    vector<int64_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t + width <= tokens.size(); t += width) {
+        int u = tokens[t], v = tokens[t + 1];
+        if (u < 0 || u >= numNodes || v < 0 || v >= numNodes) continue;
+        int weight = weighted ? tokens[t + 2] : 1;
+        int64_t a = next[u]++;
+        targets[a] = v;
+        if (weighted) weights[a] = weight;
+        if (undirected) {
+            a = next[v]++;
+            targets[a] = u;
+            if (weighted) weights[a] = weight;
+        }
+    }
+
+    ofstream out(argv[2], ios::binary);
+    if (!out) {
+        cerr << "Cannot write " << argv[2] << endl;
+        return 1;
+    }
+    out.write("ACSR", 4);
+    putUint32(out, 1);
+    putUint32(out, weighted ? CSR_FILE_WEIGHTED : 0);
+    putUint32(out, (uint32_t)numNodes);
+    uint64_t arcs = (uint64_t)numArcs;
+    out.write((const char*)&arcs, sizeof(arcs));
+    out.write((const char*)offsets.data(), offsets.size() * sizeof(int64_t));
+    out.write((const char*)targets.data(), targets.size() * sizeof(int32_t));
+    out.write((const char*)weights.data(), weights.size() * sizeof(int32_t));
+
+    if (!out) {
+        cerr << "Failed writing " << argv[2] << endl;
+        return 1;
+    }
+    cerr << "Wrote " << numNodes << " nodes, " << numArcs << " arcs to " << argv[2] << endl;
+    return 0;
+}
+
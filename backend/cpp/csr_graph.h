@@ -0,0 +1,168 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <vector>
+#include <cstdint>
+
+#include "graph_input.h"
+
+/**
+ * Compressed Sparse Row Graph
+ * Shared adjacency structure for the graph algorithms. The arcs of node u
+ * are targets[offsets[u]] .. targets[offsets[u + 1] - 1], with the matching
+ * weights[] entries, so a traversal is a linear scan over two contiguous
+ * arrays and building the graph costs three allocations in total instead
+ * of one per node.
+ *
+ * The graph is built in two passes over the input (count degrees, then
+ * fill). Arcs of a node keep the order their edges appear in the input,
+ * so traces match the order the edges were given in.
+ *
+ * A graph loaded from a CSR file (--graph) is used in place: the arrays
+ * point into the mapping, which must outlive the CsrGraph.
+ */
+
+enum CsrBuildFlags {
+    CSR_UNDIRECTED = 1,     // Add each input edge in both directions
+    CSR_WEIGHTED = 2,       // Always provide weights (1 when the input has none)
+    CSR_EDGE_LIST = 4       // Also fill the struct-of-arrays edge list
+};
+
+struct NeighborRange {
+    const int32_t* first;
+    const int32_t* last;
+
+    const int32_t* begin() const {
+        return first;
+    }
+
+    const int32_t* end() const {
+        return last;
+    }
+};
+
+class CsrGraph {
+public:
+    int numNodes;
+    int64_t numArcs;
+    const int64_t* offsets;
+    const int32_t* targets;
+    const int32_t* weights;     // Null for an unweighted graph
+    EdgeList edges;             // With CSR_EDGE_LIST: kept edges in input order
+
+    CsrGraph() : numNodes(0), numArcs(0), offsets(nullptr), targets(nullptr), weights(nullptr) {}
+
+    int64_t arcBegin(int u) const {
+        return offsets[u];
+    }
+
+    int64_t arcEnd(int u) const {
+        return offsets[u + 1];
+    }
+
+    NeighborRange neighbors(int u) const {
+        NeighborRange range = {targets + offsets[u], targets + offsets[u + 1]};
+        return range;
+    }
+
+    /**
+     * Build from loaded input. Edges with an endpoint outside the graph,
+     * or for which keep(u, v, weight) returns false, are dropped.
+     * Arcs of a CSR file are taken as they are (CSR_UNDIRECTED does not
+     * mirror them; the file already stores both directions).
+     */
+    template <typename Keep>
+    void build(const GraphInput& input, unsigned flags, Keep keep) {
+        numNodes = input.numNodes;
+        bool mirror = (flags & CSR_UNDIRECTED) && !input.isCsr();
+        bool hasWeights = input.isCsr() ? input.weights != nullptr : !input.edges.w.empty();
+        bool keepWeights = hasWeights || (flags & CSR_WEIGHTED);
+        bool edgeList = (flags & CSR_EDGE_LIST) != 0;
+        int n = numNodes;
+
+        if (input.isCsr() && !edgeList && allArcsValid(input, keep)) {
+            numArcs = input.numArcs;
+            offsets = input.offsets;
+            targets = input.targets;
+            weights = input.weights;
+            if (!weights && keepWeights) {
+                weightStorage.assign(numArcs, 1);
+                weights = weightStorage.data();
+            }
+            return;
+        }
+
+        // Pass 1: degrees, counted two slots ahead so pass 2 can use
+        // offsetStorage[u + 1] as the fill cursor of node u
+        offsetStorage.assign(n + 2, 0);
+        input.forEachEdge([&](int u, int v, int weight) {
+            if (!valid(u, v, n) || !keep(u, v, weight)) return;
+            offsetStorage[u + 2]++;
+            if (mirror) offsetStorage[v + 2]++;
+        });
+        for (int u = 0; u < n; u++) {
+            offsetStorage[u + 2] += offsetStorage[u + 1];
+        }
+
+        numArcs = offsetStorage[n + 1];
+        targetStorage.resize(numArcs);
+        weightStorage.resize(keepWeights ? numArcs : 0);
+        if (edgeList) {
+            size_t count = (size_t)(mirror ? numArcs / 2 : numArcs);
+            edges.u.reserve(count);
+            edges.v.reserve(count);
+            edges.w.reserve(count);
+        }
+
+        // Pass 2: fill; afterwards offsetStorage[u + 1] is the end of node u
+        input.forEachEdge([&](int u, int v, int weight) {
+            if (!valid(u, v, n) || !keep(u, v, weight)) return;
+            int64_t a = offsetStorage[u + 1]++;
+            targetStorage[a] = v;
+            if (keepWeights) weightStorage[a] = weight;
+            if (mirror) {
+                a = offsetStorage[v + 1]++;
+                targetStorage[a] = u;
+                if (keepWeights) weightStorage[a] = weight;
+            }
+            if (edgeList) {
+                edges.u.push_back(u);
+                edges.v.push_back(v);
+                edges.w.push_back(weight);
+            }
+        });
+        offsetStorage.pop_back();
+
+        offsets = offsetStorage.data();
+        targets = targetStorage.data();
+        weights = keepWeights ? weightStorage.data() : nullptr;
+    }
+
+    void build(const GraphInput& input, unsigned flags) {
+        build(input, flags, [](int, int, int) { return true; });
+    }
+
+private:
+    std::vector<int64_t> offsetStorage;
+    std::vector<int32_t> targetStorage;
+    std::vector<int32_t> weightStorage;
+
+    CsrGraph(const CsrGraph&);
+    CsrGraph& operator=(const CsrGraph&);
+
+    static bool valid(int u, int v, int numNodes) {
+        return u >= 0 && u < numNodes && v >= 0 && v < numNodes;
+    }
+
+    template <typename Keep>
+    static bool allArcsValid(const GraphInput& input, Keep keep) {
+        bool ok = true;
+        input.forEachEdge([&](int u, int v, int weight) {
+            if (!valid(u, v, input.numNodes) || !keep(u, v, weight)) ok = false;
+        });
+        return ok;
+    }
+};
+
+#endif
+
@@ -1,94 +1,197 @@
 #include <iostream>
 #include <vector>
-#include <stack>
 #include <sstream>
 #include <cstdlib>
+#include <cstdint>
+
+#include "algorithms.h"
+#include "csr_graph.h"
+#include "frontier_deltas.h"
+#include "graph_input.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "step_writer.h"
 
 using namespace std;
 
 /**
  * Depth-First Search (DFS)
  * Input format: <num_nodes> <start_node> <edge1_u> <edge1_v> <edge2_u> <edge2_v> ...
+ * (edges may instead come from --stdin or a --graph=<file> CSR file, see graph_input.h)
  * Outputs JSON steps for visualization
+ * With --queue-deltas the DFS stack is traced as stack_push/stack_pop
+ * steps plus occasional full stack snapshots (see frontier_deltas.h);
+ * with --stack-snapshots a full stack step follows every push and pop.
  */
 
-void outputStep(const string& type, int node1 = -1, int node2 = -1, const string& extra = "") {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
+static void outputStep(const char* type, int node1 = -1, int node2 = -1, bool backedge = false) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
     if (node1 != -1) {
-        cout << ",\"node\":" << node1;
+        out.field("node", node1);
     }
     if (node2 != -1) {
-        cout << ",\"target\":" << node2;
+        out.field("target", node2);
     }
-    if (!extra.empty()) {
-        cout << "," << extra;
+    if (backedge) {
+        out.flag("backedge");
     }
-    cout << "}" << endl;
+    out.endStep();
 }
 
-void outputStack(const stack<int>& s) {
-    cout << "{";
-    cout << "\"type\":\"stack\",\"stack\":[";
-    stack<int> temp = s;
-    vector<int> items;
-    while (!temp.empty()) {
-        items.push_back(temp.top());
-        temp.pop();
-    }
-    for (int i = items.size() - 1; i >= 0; i--) {
-        if (i < items.size() - 1) cout << ",";
-        cout << items[i];
+// One level of the search: a node, the node it was reached from and the
+// next of its arcs to look at
+struct Frame {
+    int node;
+    int parent;
+    int64_t cursor;
+};
+
+// Stack contents from bottom to top
+static void outputStack(const vector<Frame>& stack) {
+    StepWriter& out = stepWriter();
+    if (!out.emits(TRACE_FULL)) return;
+    out.beginStep("stack");
+    out.beginList("stack");
+    for (const Frame& frame : stack) {
+        out.item(frame.node);
     }
-    cout << "]}" << endl;
+    out.endList();
+    out.endStep();
 }
 
-void dfsRecursive(const vector<vector<int>>& graph, vector<bool>& visited, int node, int parent = -1) {
-    visited[node] = true;
-    outputStep("visit", node);
-    
-    if (parent != -1) {
-        outputStep("explore", parent, node);
-    }
-    
-    for (int neighbor : graph[node]) {
-        if (!visited[neighbor]) {
+/**
+ * Depth-first search with an explicit stack of frames instead of
+ * recursion, so depth is bounded by heap memory rather than the native
+ * stack. Emits exactly the steps the recursive formulation would:
+ * visit(node) and explore(parent, node) on entry, then per arc either
+ * explore(node, neighbor) before descending or explore(...backedge) for
+ * an already visited neighbor other than the parent.
+ * With snapshots, a full stack step follows every push and pop.
+ * Keyframes hold the visited nodes and the stack.
+ */
+static void dfsIterative(const CsrGraph& graph, int startNode, FrontierDeltas& deltas, bool snapshots,
+                         Keyframes& keyframes) {
+    vector<uint64_t> visited(((size_t)graph.numNodes + 63) / 64, 0);
+    vector<Frame> stack;
+    OpCounters& ops = runMetrics().ops;
+
+    auto stackChanged = [&]() {
+        if (deltas.enabled) {
+            if (deltas.snapshotDue(stack.size())) {
+                outputStack(stack);
+            }
+        } else if (snapshots) {
+            outputStack(stack);
+        }
+    };
+
+    auto enter = [&](int node, int parent) {
+        visited[node / 64] |= 1ULL << (node % 64);
+        Frame frame = {node, parent, graph.arcBegin(node)};
+        stack.push_back(frame);
+        ops.pushes++;
+        if (deltas.enabled) {
+            deltas.push(node);
+        }
+        stackChanged();
+        outputStep("visit", node);
+        
+        if (parent != -1) {
+            outputStep("explore", parent, node);
+        }
+    };
+
+    auto outputKeyframe = [&]() {
+        StepWriter& out = stepWriter();
+        keyframes.begin();
+        out.beginList("visited");
+        for (int v = 0; v < graph.numNodes; v++) {
+            if (visited[v / 64] & (1ULL << (v % 64))) out.item(v);
+        }
+        out.endList();
+        out.beginList("frontier");
+        for (const Frame& frame : stack) {
+            out.item(frame.node);
+        }
+        out.endList();
+        keyframes.end();
+    };
+
+    enter(startNode, -1);
+    while (!stack.empty()) {
+        if (keyframes.due()) {
+            outputKeyframe();
+        }
+        Frame& top = stack.back();
+        int node = top.node;
+
+        if (top.cursor == graph.arcEnd(node)) {
+            stack.pop_back();
+            ops.pops++;
+            if (deltas.enabled) {
+                deltas.pop(node);
+            }
+            stackChanged();
+            continue;
+        }
+
+        int neighbor = graph.targets[top.cursor++];
+        ops.relaxations++;
+        if (!(visited[neighbor / 64] & (1ULL << (neighbor % 64)))) {
             outputStep("explore", node, neighbor);
-            dfsRecursive(graph, visited, neighbor, node);
-        } else if (neighbor != parent) {
-            outputStep("explore", node, neighbor, "\"backedge\":true");
+            enter(neighbor, node);
+        } else if (neighbor != top.parent) {
+            outputStep("explore", node, neighbor, true);
         }
     }
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 4) {
+int runDFS(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
+    if (argc < 3) {
         cerr << "Usage: " << argv[0] << " <num_nodes> <start_node> <edge1_u> <edge1_v> ..." << endl;
         return 1;
     }
 
-    int numNodes = atoi(argv[1]);
+    GraphInput input;
+    if (!loadGraph(opts, argc, argv, 3, false, input)) {
+        return 1;
+    }
     int startNode = atoi(argv[2]);
-    
-    vector<vector<int>> graph(numNodes);
-    
-    // Parse edges
-    for (int i = 3; i < argc; i += 2) {
-        if (i + 1 < argc) {
-            int u = atoi(argv[i]);
-            int v = atoi(argv[i + 1]);
-            if (u >= 0 && u < numNodes && v >= 0 && v < numNodes) {
-                graph[u].push_back(v);
-                graph[v].push_back(u); // Undirected graph
-            }
-        }
+    if (startNode < 0 || startNode >= input.numNodes) {
+        cerr << "start_node " << startNode << " is not a node" << endl;
+        return 1;
     }
 
-    vector<bool> visited(numNodes, false);
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"visit"}, "node target backedge?", TRACE_RESULT);
+    out.declareSteps({"explore"}, "node target backedge?");
+    out.declareSteps({"stack"}, "stack[]");
+    FrontierDeltas deltas(opts, FrontierDeltas::STACK);
+    Keyframes keyframes(opts);
+
     
+    metrics.phase(PHASE_BUILD);
+    CsrGraph graph;
+    graph.build(input, CSR_UNDIRECTED); // Undirected graph
+    metrics.phase(PHASE_RUN);
+
     // Start DFS
-    dfsRecursive(graph, visited, startNode);
+    dfsIterative(graph, startNode, deltas, opts.has("stack-snapshots"), keyframes);
+
+    metrics.phase(PHASE_EMIT);
+    finishMetrics();
 
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runDFS(argc, argv);
+}
+#endif
+
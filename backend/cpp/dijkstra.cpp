@@ -1,114 +1,707 @@
 #include <iostream>
 #include <vector>
-#include <queue>
 #include <climits>
+#include <cmath>
+#include <fstream>
+#include <atomic>
+#include <algorithm>
 #include <sstream>
 #include <cstdlib>
 
+#include "algorithms.h"
+#include "csr_graph.h"
+#include "frontier_deltas.h"
+#include "graph_input.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "parallel.h"
+#include "priority_queues.h"
+#include "step_writer.h"
+
 using namespace std;
 
 /**
  * Dijkstra's Algorithm
  * Input format: <num_nodes> <start_node> <edge1_u> <edge1_v> <weight> <edge2_u> <edge2_v> <weight> ...
+ * (edges may instead come from --stdin or a --graph=<file> CSR file, see graph_input.h)
  * Outputs JSON steps for visualization
+ * With --queue-deltas the priority queue is traced as queue_push,
+ * queue_decrease and queue_pop steps plus occasional full snapshots
+ * (see frontier_deltas.h).
+ * --heap selects the priority queue (see priority_queues.h):
+ *   binary (default) lazy-deletion binary heap
+ *   dary             indexed 4-ary heap with decrease-key
+ *   radix            radix heap
+ * The enqueue/update_distance steps are the same for all three; with the
+ * indexed heap, priority_queue snapshots hold no stale entries.
+ *
+ * --delta-stepping[=<width>] runs multithreaded delta-stepping instead
+ * (--threads=<n>, default: all cores; width defaults to the mean arc
+ * weight). It yields the same distances, traced only as visit steps in
+ * distance order, plus a bucket step per settled bucket with --bucket-trace;
+ * its --keyframes are written between buckets.
+ *
+ * Point-to-point queries give --target=<node>; the search then stops as
+ * soon as the target is settled and ends with a path step listing the
+ * nodes from start to target and the distance (an empty path if the
+ * target is unreachable). With --verbosity=result that is just the
+ * settled nodes and the path.
+ *   --bidirectional  searches from both ends at once, traced as visit and
+ *                    reverse_visit steps (distance from start / from the
+ *                    target), stopping once no shorter connection can be
+ *                    found; its --keyframes mark both visited sets
+ *   --coords=<x0>,<y0>,<x1>,<y1>,...  or  --coords-file=<file> (x y per
+ *                    node, whitespace separated) turn the search into A*
+ *                    with the straight-line distance to the target as the
+ *                    heuristic (--heuristic=manhattan for grids). No edge
+ *                    may be shorter than that distance between its ends;
+ *                    the coordinates are rejected if one is.
  */
 
-void outputStep(const string& type, int node1 = -1, int node2 = -1, int value = -1, const string& extra = "") {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
+static void outputStep(const char* type, int node1 = -1, int node2 = -1, int value = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
     if (node1 != -1) {
-        cout << ",\"node\":" << node1;
+        out.field("node", node1);
     }
     if (node2 != -1) {
-        cout << ",\"target\":" << node2;
+        out.field("target", node2);
     }
     if (value != -1) {
-        cout << ",\"distance\":" << value;
-    }
-    if (!extra.empty()) {
-        cout << "," << extra;
+        out.field("distance", value);
     }
-    cout << "}" << endl;
+    out.endStep();
 }
 
-void outputQueue(const priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>>& pq) {
-    cout << "{";
-    cout << "\"type\":\"priority_queue\",\"queue\":[";
-    auto temp = pq;
-    bool first = true;
-    while (!temp.empty()) {
-        if (!first) cout << ",";
-        cout << "{\"node\":" << temp.top().second << ",\"dist\":" << temp.top().first << "}";
-        temp.pop();
-        first = false;
-    }
-    cout << "]}" << endl;
+// A* heuristic value of a node; an empty potential is plain Dijkstra
+static inline int potentialOf(const vector<int>& potential, int node) {
+    return potential.empty() ? 0 : potential[node];
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 5) {
-        cerr << "Usage: " << argv[0] << " <num_nodes> <start_node> <edge1_u> <edge1_v> <weight> ..." << endl;
-        return 1;
+/**
+ * Output the queue in pop order. When `dist` and `visited` are given,
+ * stale entries left behind by lazy deletion are skipped, so the snapshot
+ * matches the queue described by the delta steps. A* entries are keyed
+ * by distance plus potential but shown with their distance.
+ */
+template <typename Queue>
+static void outputQueue(const Queue& pq, const vector<int>& potential, const vector<int>* dist = nullptr,
+                        const vector<bool>* visited = nullptr) {
+    StepWriter& out = stepWriter();
+    if (!out.emits(TRACE_FULL)) return;
+
+    vector<pair<int, int>> entries;
+    pq.entries(entries);
+
+    out.beginStep("priority_queue");
+    out.beginList("queue");
+    for (const pair<int, int>& entry : entries) {
+        int node = entry.second;
+        int d = entry.first - potentialOf(potential, node);
+        if (!dist || (!(*visited)[node] && (*dist)[node] == d)) {
+            out.pair("node", node, "dist", d);
+        }
     }
+    out.endList();
+    out.endStep();
+}
 
-    int numNodes = atoi(argv[1]);
-    int startNode = atoi(argv[2]);
-    
-    vector<vector<pair<int, int>>> graph(numNodes); // {neighbor, weight}
-    
-    // Parse edges with weights
-    for (int i = 3; i < argc; i += 3) {
-        if (i + 2 < argc) {
-            int u = atoi(argv[i]);
-            int v = atoi(argv[i + 1]);
-            int weight = atoi(argv[i + 2]);
-            if (u >= 0 && u < numNodes && v >= 0 && v < numNodes && weight >= 0) {
-                graph[u].push_back({v, weight});
-                graph[v].push_back({u, weight}); // Undirected graph
-            }
+// Tentative distances with -1 for unreached nodes
+static void outputDistances(const vector<int>& dist) {
+    StepWriter& out = stepWriter();
+    out.beginList("distance");
+    for (int d : dist) {
+        out.item(d == INT_MAX ? -1 : d);
+    }
+    out.endList();
+}
+
+/**
+ * Keyframe of the heap-based search: visited nodes, distances and the
+ * live queue entries in pop order.
+ */
+template <typename Queue>
+static void outputKeyframe(Keyframes& keyframes, const Queue& pq, const vector<int>& potential,
+                           const vector<int>& dist, const vector<bool>& visited) {
+    vector<pair<int, int>> entries;
+    pq.entries(entries);
+
+    StepWriter& out = stepWriter();
+    keyframes.begin();
+    keyframes.marked("visited", visited);
+    outputDistances(dist);
+    out.beginList("frontier");
+    for (const pair<int, int>& entry : entries) {
+        int node = entry.second;
+        if (!visited[node] && dist[node] + potentialOf(potential, node) == entry.first) {
+            out.item(node);
         }
     }
+    out.endList();
+    keyframes.end();
+}
+
+/**
+ * The path step of a --target query: start to target, or empty with no
+ * distance when the target was not reached.
+ */
+static void outputPath(const vector<int>& path, int distance) {
+    StepWriter& out = stepWriter();
+    out.beginStep("path");
+    out.beginList("path");
+    for (int node : path) {
+        out.item(node);
+    }
+    out.endList();
+    if (!path.empty()) {
+        out.field("distance", distance);
+    }
+    out.endStep();
+}
+
+// Nodes from the root of `parent` to `node`, in root-first order
+static void appendPathTo(vector<int>& path, const vector<int>& parent, int node) {
+    size_t first = path.size();
+    for (int v = node; v != -1; v = parent[v]) {
+        path.push_back(v);
+    }
+    reverse(path.begin() + first, path.end());
+}
 
+/**
+ * Heap-based Dijkstra from startNode. With a target (>= 0) it stops once
+ * the target is settled and outputs the path; a non-empty potential
+ * (consistent heuristic values) makes it A*, keying the queue by
+ * distance + potential.
+ */
+template <typename Queue>
+static void dijkstra(const CsrGraph& graph, int startNode, int target, const vector<int>& potential,
+                     FrontierDeltas& deltas, Keyframes& keyframes) {
+    int numNodes = graph.numNodes;
     vector<int> dist(numNodes, INT_MAX);
     vector<bool> visited(numNodes, false);
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+    vector<int> parent(target >= 0 ? numNodes : 0, -1);
+    Queue pq(numNodes);
+    vector<bool> queued(numNodes, false); // Has a live queue entry (delta mode)
+    size_t queuedCount = 0;
+    OpCounters& ops = runMetrics().ops;
     
     dist[startNode] = 0;
-    pq.push({0, startNode});
+    pq.push(startNode, potentialOf(potential, startNode));
+    ops.pushes++;
     outputStep("enqueue", startNode, -1, 0);
-    outputQueue(pq);
+    if (deltas.enabled) {
+        deltas.push(startNode, 0);
+        queued[startNode] = true;
+        queuedCount++;
+    }
+    outputQueue(pq, potential);
     
     while (!pq.empty()) {
-        int u = pq.top().second;
-        pq.pop();
+        if (keyframes.due()) {
+            outputKeyframe(keyframes, pq, potential, dist, visited);
+        }
+        int u, d;
+        pq.popMin(u, d);
+        ops.pops++;
         
-        if (visited[u]) continue;
+        if (visited[u]) {
+            ops.stalePops++;
+            continue;
+        }
         
         visited[u] = true;
+        if (deltas.enabled) {
+            deltas.pop(u);
+            queued[u] = false;
+            queuedCount--;
+        }
         outputStep("visit", u, -1, dist[u]);
+        if (u == target) break;
         
-        for (auto& edge : graph[u]) {
-            int v = edge.first;
-            int weight = edge.second;
+        for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+            int v = graph.targets[a];
+            int weight = graph.weights[a];
             
             outputStep("explore", u, v, weight);
+            ops.relaxations++;
             
             if (!visited[v] && dist[u] + weight < dist[v]) {
                 dist[v] = dist[u] + weight;
-                pq.push({dist[v], v});
+                if (target >= 0) parent[v] = u;
+                pq.push(v, dist[v] + potentialOf(potential, v));
+                ops.pushes++;
                 outputStep("update_distance", v, -1, dist[v]);
                 outputStep("enqueue", v, -1, dist[v]);
+                if (deltas.enabled) {
+                    if (queued[v]) {
+                        deltas.decrease(v, dist[v]);
+                    } else {
+                        deltas.push(v, dist[v]);
+                        queued[v] = true;
+                        queuedCount++;
+                    }
+                }
             }
         }
         
-        if (!pq.empty()) {
-            outputQueue(pq);
+        if (deltas.enabled) {
+            if (deltas.snapshotDue(queuedCount)) {
+                outputQueue(pq, potential, &dist, &visited);
+            }
+        } else if (!pq.empty()) {
+            outputQueue(pq, potential);
         }
     }
     
+    if (target >= 0) {
+        vector<int> path;
+        if (visited[target]) {
+            appendPathTo(path, parent, target);
+        }
+        outputPath(path, dist[target]);
+        return;
+    }
+
     // Output empty queue at the end
-    outputQueue(pq);
+    outputQueue(pq, potential);
+}
+
+/**
+ * One direction of the bidirectional search; the graph is undirected, so
+ * both walk the same arcs.
+ */
+template <typename Queue>
+struct SearchSide {
+    vector<int> dist;
+    vector<int> parent;
+    vector<bool> settled;
+    Queue pq;
+    int last;               // Last settled distance, a lower bound for the queue
+    const char* visitStep;
+
+    SearchSide(int numNodes, int root, const char* visitStep)
+        : dist(numNodes, INT_MAX), parent(numNodes, -1), settled(numNodes, false), pq(numNodes), last(0),
+          visitStep(visitStep) {
+        dist[root] = 0;
+        pq.push(root, 0);
+    }
+};
+
+/**
+ * Bidirectional Dijkstra: a forward search from startNode and a reverse
+ * search from target, each step settling a node on the side whose last
+ * settled distance is lower. Every relaxed arc that reaches a node the
+ * other side has a distance for is a candidate connection; the best one
+ * is the shortest path once the two sides' last settled distances add up
+ * to at least its length, since no unsettled node can lie on a shorter
+ * one.
+ */
+template <typename Queue>
+static void bidirectionalDijkstra(const CsrGraph& graph, int startNode, int target, Keyframes& keyframes) {
+    int numNodes = graph.numNodes;
+    SearchSide<Queue> forward(numNodes, startNode, "visit");
+    SearchSide<Queue> backward(numNodes, target, "reverse_visit");
+    OpCounters& ops = runMetrics().ops;
+    ops.pushes += 2;
+
+    // Best connection found: forward-side node meetFrom, arc to meetTo
+    long long best = LLONG_MAX;
+    int meetFrom = -1, meetTo = -1;
+    if (startNode == target) {
+        best = 0;
+        meetFrom = meetTo = startNode;
+    }
+
+    while (!forward.pq.empty() && !backward.pq.empty()) {
+        if ((long long)forward.last + backward.last >= best) break;
+        if (keyframes.due()) {
+            keyframes.begin();
+            keyframes.marked("visited", forward.settled);
+            keyframes.marked("reverse_visited", backward.settled);
+            outputDistances(forward.dist);
+            keyframes.end();
+        }
+
+        bool isForward = forward.last <= backward.last;
+        SearchSide<Queue>& side = isForward ? forward : backward;
+        SearchSide<Queue>& other = isForward ? backward : forward;
+
+        int u, d;
+        side.pq.popMin(u, d);
+        ops.pops++;
+        if (side.settled[u]) {
+            ops.stalePops++;
+            continue;
+        }
+        side.settled[u] = true;
+        side.last = d;
+        outputStep(side.visitStep, u, -1, d);
+
+        for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+            int v = graph.targets[a];
+            int weight = graph.weights[a];
+            ops.relaxations++;
+
+            if (!side.settled[v] && d + weight < side.dist[v]) {
+                side.dist[v] = d + weight;
+                side.parent[v] = u;
+                side.pq.push(v, side.dist[v]);
+                ops.pushes++;
+            }
+            if (other.dist[v] != INT_MAX && (long long)d + weight + other.dist[v] < best) {
+                best = (long long)d + weight + other.dist[v];
+                meetFrom = isForward ? u : v;
+                meetTo = isForward ? v : u;
+            }
+        }
+    }
+
+    vector<int> path;
+    if (meetFrom != -1) {
+        appendPathTo(path, forward.parent, meetFrom);
+        for (int v = meetTo; v != -1 && v != meetFrom; v = backward.parent[v]) {
+            path.push_back(v);
+        }
+    }
+    outputPath(path, (int)(meetFrom != -1 ? best : -1));
+}
+
+static const size_t DELTA_GRAIN = 256;
+
+// Lower dist[v] to candidate if that is smaller; true if this call lowered it
+static bool lowerDistance(vector<atomic<int>>& dist, int v, int candidate) {
+    int current = dist[v].load(memory_order_relaxed);
+    while (candidate < current) {
+        if (dist[v].compare_exchange_weak(current, candidate, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Parallel delta-stepping. Tentative distances are grouped into buckets
+ * of width delta. The lowest non-empty bucket is settled by relaxing the
+ * light arcs (weight <= delta) of its nodes in parallel until it stops
+ * refilling, then the heavy arcs of everything it settled are relaxed
+ * once. Only maxWeight / delta + 2 buckets can hold live entries at a
+ * time, so the bucket array is cyclic.
+ * Settled nodes are reported as visit steps, bucket by bucket in
+ * distance order; with bucketTrace each bucket is preceded by a bucket
+ * step (index, lower distance bound, number of nodes settled).
+ */
+static void deltaStepping(const CsrGraph& graph, int startNode, int delta, WorkerPool& pool, bool bucketTrace,
+                          Keyframes& keyframes) {
+    int n = graph.numNodes;
+    int maxWeight = 0;
+    for (int64_t a = 0; a < graph.numArcs; a++) {
+        maxWeight = max(maxWeight, graph.weights[a]);
+    }
+
+    size_t slots = (size_t)(maxWeight / delta) + 2;
+    vector<vector<int>> buckets(slots);
+    vector<int> queuedIn(n, -1);          // Bucket index holding the live entry of a node
+    vector<bool> settled(n, false);
+    vector<atomic<int>> dist(n);
+    for (int v = 0; v < n; v++) {
+        dist[v].store(INT_MAX, memory_order_relaxed);
+    }
+    vector<vector<int>> lowered(pool.size()); // Per worker: nodes whose distance dropped
+    OpCounters& ops = runMetrics().ops;
+
+    // Queue every lowered node in the bucket of its new distance
+    auto collect = [&]() {
+        for (vector<int>& nodes : lowered) {
+            for (int v : nodes) {
+                int b = dist[v].load(memory_order_relaxed) / delta;
+                if (queuedIn[v] != b) {
+                    queuedIn[v] = b;
+                    buckets[b % slots].push_back(v);
+                    ops.pushes++;
+                }
+            }
+            nodes.clear();
+        }
+    };
+
+    auto relax = [&](const vector<int>& nodes, bool light) {
+        pool.parallelFor(nodes.size(), DELTA_GRAIN, [&](size_t begin, size_t end, int worker) {
+            vector<int>& out = lowered[worker];
+            long long relaxed = 0;
+            for (size_t i = begin; i < end; i++) {
+                int u = nodes[i];
+                int du = dist[u].load(memory_order_relaxed);
+                for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+                    int weight = graph.weights[a];
+                    if ((weight <= delta) != light) continue;
+                    int v = graph.targets[a];
+                    relaxed++;
+                    if (lowerDistance(dist, v, du + weight)) {
+                        out.push_back(v);
+                    }
+                }
+            }
+            Metrics::countShared(ops.relaxations, relaxed);
+        });
+        collect();
+    };
+
+    StepWriter& out = stepWriter();
+    dist[startNode].store(0, memory_order_relaxed);
+    queuedIn[startNode] = 0;
+    buckets[0].push_back(startNode);
+
+    vector<int> frontier, done;
+    int current = 0;
+    while (true) {
+        // Next bucket with entries; all live entries lie within `slots` buckets
+        size_t step = 0;
+        while (step < slots && buckets[(current + step) % slots].empty()) {
+            step++;
+        }
+        if (step == slots) break;
+        current += (int)step;
+        vector<int>& bucket = buckets[current % slots];
+
+        done.clear();
+        while (!bucket.empty()) {
+            frontier.clear();
+            for (int v : bucket) {
+                ops.pops++;
+                if (queuedIn[v] == current) {
+                    queuedIn[v] = -1;
+                    frontier.push_back(v);
+                    if (!settled[v]) {
+                        settled[v] = true;
+                        done.push_back(v);
+                    }
+                } else {
+                    ops.stalePops++;
+                }
+            }
+            bucket.clear();
+            relax(frontier, true);
+        }
+        relax(done, false);
+
+        if (done.empty()) {
+            current++;
+            continue;
+        }
+        sort(done.begin(), done.end(), [&](int a, int b) {
+            int da = dist[a].load(memory_order_relaxed), db = dist[b].load(memory_order_relaxed);
+            return da < db || (da == db && a < b);
+        });
+        if (bucketTrace) {
+            out.beginStep("bucket");
+            out.field("index", current);
+            out.field("distance", (long long)current * delta);
+            out.field("size", (long long)done.size());
+            out.endStep();
+        }
+        for (int v : done) {
+            outputStep("visit", v, -1, dist[v].load(memory_order_relaxed));
+        }
+        current++;
+
+        // Only settled distances have been traced so far
+        if (keyframes.due()) {
+            vector<int> shown(n, INT_MAX);
+            for (int v = 0; v < n; v++) {
+                if (settled[v]) shown[v] = dist[v].load(memory_order_relaxed);
+            }
+            keyframes.begin();
+            keyframes.marked("visited", settled);
+            outputDistances(shown);
+            keyframes.end();
+        }
+    }
+}
+
+/**
+ * Read the --coords / --coords-file coordinates, two per node, into
+ * coords. Returns false and prints a message on failure.
+ */
+static bool loadCoordinates(const Options& opts, int numNodes, vector<double>& coords) {
+    if (opts.has("coords-file")) {
+        string path = opts.get("coords-file");
+        ifstream file(path);
+        if (!file) {
+            cerr << "Cannot open --coords-file '" << path << "'" << endl;
+            return false;
+        }
+        double value;
+        while (file >> value) {
+            coords.push_back(value);
+        }
+    } else {
+        string list = opts.get("coords");
+        const char* p = list.c_str();
+        while (*p) {
+            char* end;
+            coords.push_back(strtod(p, &end));
+            if (end == p || (*end && *end != ',')) {
+                cerr << "Bad --coords value '" << list << "'" << endl;
+                return false;
+            }
+            p = *end ? end + 1 : end;
+        }
+    }
+    if (coords.size() != (size_t)numNodes * 2) {
+        cerr << "Expected " << numNodes * 2 << " coordinates (x y per node), got " << coords.size() << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * A* potentials: each node's straight-line (or Manhattan) distance to the
+ * target, rounded down. Rounding down an integer-weight consistent
+ * heuristic keeps it consistent, so nodes are still settled once and in
+ * key order (as the radix heap needs). Returns false if an arc is shorter
+ * than the heuristic allows.
+ */
+static bool buildPotentials(const CsrGraph& graph, const vector<double>& coords, int target, bool manhattan,
+                            vector<int>& potential) {
+    int n = graph.numNodes;
+    double tx = coords[2 * target], ty = coords[2 * target + 1];
+    potential.resize(n);
+    for (int v = 0; v < n; v++) {
+        double dx = fabs(coords[2 * v] - tx), dy = fabs(coords[2 * v + 1] - ty);
+        double h = manhattan ? dx + dy : sqrt(dx * dx + dy * dy);
+        potential[v] = (int)min(floor(h), (double)(INT_MAX / 2));
+    }
+
+    for (int u = 0; u < n; u++) {
+        for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+            int v = graph.targets[a];
+            if ((long long)potential[u] > (long long)graph.weights[a] + potential[v]) {
+                cerr << "Edge " << u << "-" << v << " (weight " << graph.weights[a]
+                     << ") is shorter than its ends' distance apart; the coordinates cannot guide A*" << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int runDijkstra(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <num_nodes> <start_node> <edge1_u> <edge1_v> <weight> ..." << endl;
+        return 1;
+    }
+
+    string heap = opts.get("heap", "binary");
+    if (heap != "binary" && heap != "dary" && heap != "radix") {
+        cerr << "Unknown --heap '" << heap << "' (expected binary, dary or radix)" << endl;
+        return 1;
+    }
+
+    int target = (int)opts.getInt("target", -1);
+    bool bidirectional = opts.has("bidirectional");
+    bool astar = opts.has("coords") || opts.has("coords-file");
+    string heuristic = opts.get("heuristic", "euclidean");
+    if ((bidirectional || astar) && target < 0) {
+        cerr << "--bidirectional and --coords need a --target" << endl;
+        return 1;
+    }
+    if (target >= 0 && opts.has("delta-stepping")) {
+        cerr << "--target cannot be combined with --delta-stepping" << endl;
+        return 1;
+    }
+    if (bidirectional && astar) {
+        cerr << "--bidirectional cannot be combined with --coords" << endl;
+        return 1;
+    }
+    if (heuristic != "euclidean" && heuristic != "manhattan") {
+        cerr << "Unknown --heuristic '" << heuristic << "' (expected euclidean or manhattan)" << endl;
+        return 1;
+    }
+
+    GraphInput input;
+    if (!loadGraph(opts, argc, argv, 3, true, input)) {
+        return 1;
+    }
+    int startNode = atoi(argv[2]);
+    if (startNode < 0 || startNode >= input.numNodes) {
+        cerr << "start_node " << startNode << " is not a node" << endl;
+        return 1;
+    }
+    if (target >= input.numNodes) {
+        cerr << "--target " << target << " is not a node" << endl;
+        return 1;
+    }
+    vector<double> coords;
+    if (astar && !loadCoordinates(opts, input.numNodes, coords)) {
+        return 1;
+    }
+
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"enqueue"}, "node target distance", TRACE_EVENTS);
+    out.declareSteps({"visit"}, "node target distance", TRACE_RESULT);
+    out.declareSteps({"explore"}, "node target distance");
+    out.declareSteps({"update_distance"}, "node target distance", TRACE_EVENTS);
+    out.declareSteps({"priority_queue"}, "queue[node,dist]");
+    FrontierDeltas deltas(opts, FrontierDeltas::QUEUE);
+    Keyframes keyframes(opts);
+
+    
+    // Undirected graph; negative weights are dropped
+    metrics.phase(PHASE_BUILD);
+    CsrGraph graph;
+    graph.build(input, CSR_UNDIRECTED | CSR_WEIGHTED, [](int, int, int weight) { return weight >= 0; });
+    vector<int> potential;
+    if (astar && !buildPotentials(graph, coords, target, heuristic == "manhattan", potential)) {
+        return 1;
+    }
+    if (target >= 0) {
+        out.declareSteps({"path"}, "path[] distance", TRACE_RESULT);
+    }
+    metrics.phase(PHASE_RUN);
+
+    if (opts.has("delta-stepping")) {
+        // Default bucket width: the mean arc weight
+        long long total = 0;
+        for (int64_t a = 0; a < graph.numArcs; a++) {
+            total += graph.weights[a];
+        }
+        long long mean = graph.numArcs > 0 ? (total + graph.numArcs - 1) / graph.numArcs : 1;
+        int delta = (int)max(1LL, opts.getInt("delta-stepping", mean));
+
+        out.declareSteps({"bucket"}, "index distance size", TRACE_SUMMARY);
+        WorkerPool pool(threadCount(opts));
+        deltaStepping(graph, startNode, delta, pool, opts.has("bucket-trace"), keyframes);
+    } else if (bidirectional) {
+        out.declareSteps({"reverse_visit"}, "node target distance", TRACE_RESULT);
+        if (heap == "dary") {
+            bidirectionalDijkstra<IndexedDaryHeap<4>>(graph, startNode, target, keyframes);
+        } else if (heap == "radix") {
+            bidirectionalDijkstra<RadixHeap>(graph, startNode, target, keyframes);
+        } else {
+            bidirectionalDijkstra<LazyBinaryHeap>(graph, startNode, target, keyframes);
+        }
+    } else if (heap == "dary") {
+        dijkstra<IndexedDaryHeap<4>>(graph, startNode, target, potential, deltas, keyframes);
+    } else if (heap == "radix") {
+        dijkstra<RadixHeap>(graph, startNode, target, potential, deltas, keyframes);
+    } else {
+        dijkstra<LazyBinaryHeap>(graph, startNode, target, potential, deltas, keyframes);
+    }
+
+    metrics.phase(PHASE_EMIT);
+    finishMetrics();
 
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runDijkstra(argc, argv);
+}
+#endif
+
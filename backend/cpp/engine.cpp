@@ -0,0 +1,621 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
+#include "algorithms.h"
+#include "step_writer.h"
+#include "trace_cache.h"
+
+using namespace std;
+
+/**
+ * Algorithm Engine
+ * Long-lived process that links every algorithm and serves them over a
+ * framed protocol, so callers keep warm workers instead of starting one
+ * process per request.
+ *
+ * Usage: engine [--socket <path>] [--cache <dir> [--cache-size <bytes>]]
+ *   --socket      serve requests on a Unix domain socket (one forked
+ *                 worker per connection) instead of stdin/stdout
+ *   --cache       keep complete traces in <dir> and replay them for
+ *                 repeated requests (see trace_cache.h); the directory
+ *                 may be shared by several engines
+ *   --cache-size  disk budget of the cache, default 1 GiB
+ *
+ * Request frame:   <uint32 length> <payload>
+ *   payload is whitespace-separated tokens: <algorithm> <args...>, where
+ *   args are exactly what the standalone program takes on its command line.
+ * Response frames: <uint32 length> <uint32 kind> <payload>
+ *   kind 0 (data): the next chunk of the trace, sent as soon as the step
+ *                  writer flushes it; each chunk holds whole steps
+ *   kind 1 (end):  payload is the int32 exit code followed by what the
+ *                  request wrote to stderr (usually empty), ends the response
+ *   kind 2 (page): empty, ends a page of a trace session that goes on
+ * All integers are little-endian.
+ *
+ * Payloads starting with '@' are trace session commands (see
+ * TraceSessions): a session produces its trace page by page, as far as
+ * the client asks for it.
+ */
+
+static const uint32_t FRAME_DATA = 0;
+static const uint32_t FRAME_END = 1;
+static const uint32_t FRAME_PAGE = 2;
+static const uint32_t MAX_REQUEST_SIZE = 256u * 1024 * 1024;
+
+struct Algorithm {
+    const char* name;
+    int (*run)(int argc, char* argv[]);
+};
+
+static const Algorithm algorithms[] = {
+    {"bubble", runBubbleSort},
+    {"selection", runSelectionSort},
+    {"insertion", runInsertionSort},
+    {"merge", runMergeSort},
+    {"pdqsort", runPdqSort},
+    {"radix", runRadixSort},
+    {"bfs", runBFS},
+    {"dfs", runDFS},
+    {"dijkstra", runDijkstra},
+    {"bellman_ford", runBellmanFord},
+    {"floyd_warshall", runFloydWarshall},
+};
+
+static const Algorithm* findAlgorithm(const string& name) {
+    for (const Algorithm& algo : algorithms) {
+        if (name == algo.name) {
+            return &algo;
+        }
+    }
+    return nullptr;
+}
+
+static bool readExact(int fd, char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int n = _read(fd, data, (unsigned int)size);
+#else
+        ssize_t n = read(fd, data, size);
+#endif
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, (unsigned int)size);
+#else
+        ssize_t n = write(fd, data, size);
+#endif
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+static void putUint32(char* out, uint32_t value) {
+    out[0] = (char)(value & 0xff);
+    out[1] = (char)((value >> 8) & 0xff);
+    out[2] = (char)((value >> 16) & 0xff);
+    out[3] = (char)((value >> 24) & 0xff);
+}
+
+static uint32_t getUint32(const char* in) {
+    const unsigned char* p = (const unsigned char*)in;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool writeFrame(int fd, uint32_t kind, const char* data, size_t size) {
+    char header[8];
+    putUint32(header, (uint32_t)size);
+    putUint32(header + 4, kind);
+    return writeAll(fd, header, sizeof(header)) && writeAll(fd, data, size);
+}
+
+static bool writeEnd(int fd, int code, const string& message = string()) {
+    string status(4, '\0');
+    putUint32(&status[0], (uint32_t)code);
+    status += message;
+    return writeFrame(fd, FRAME_END, status.data(), status.size());
+}
+
+/**
+ * Collects what a request writes to cerr while it is alive, so the
+ * message goes back to the client in the end frame instead of to the
+ * engine's shared stderr.
+ */
+class ErrorCapture {
+public:
+    ErrorCapture() : previous(cerr.rdbuf(text.rdbuf())) {}
+
+    ~ErrorCapture() {
+        cerr.rdbuf(previous);
+    }
+
+    string str() const {
+        return text.str();
+    }
+
+private:
+    ostringstream text;
+    streambuf* previous;
+};
+
+/**
+ * Stream buffer that sends every write as one data frame, so the trace
+ * reaches the client while the algorithm is still running and its size
+ * is not limited by memory.
+ */
+class FrameStreamBuf : public streambuf {
+public:
+    explicit FrameStreamBuf(int fd) : fd(fd), failed(false), cache(nullptr) {}
+
+    bool ok() const {
+        return !failed;
+    }
+
+    // Also hand every chunk to the cache's current recording (null to stop)
+    void recordTo(TraceCache* recorder) {
+        cache = recorder;
+    }
+
+protected:
+    streamsize xsputn(const char* data, streamsize size) override {
+        if (size > 0 && !failed && !writeFrame(fd, FRAME_DATA, data, (size_t)size)) {
+            failed = true;
+        }
+        if (size > 0 && cache) {
+            cache->record(data, (size_t)size);
+        }
+        return size;
+    }
+
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            char ch = (char)c;
+            xsputn(&ch, 1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+private:
+    int fd;
+    bool failed;
+    TraceCache* cache;
+};
+
+/**
+ * Split a request into its arguments and find its algorithm; null (after
+ * saying why on stderr) when it cannot be run.
+ */
+static const Algorithm* parseRequest(const string& payload, vector<string>& args) {
+    istringstream tokens(payload);
+    string token;
+    while (tokens >> token) {
+        args.push_back(token);
+    }
+
+    if (args.empty()) {
+        cerr << "engine: empty request" << endl;
+        return nullptr;
+    }
+
+    const Algorithm* algo = findAlgorithm(args[0]);
+    if (!algo) {
+        cerr << "engine: unknown algorithm '" << args[0] << "'" << endl;
+        return nullptr;
+    }
+
+    // stdin is the request channel here, so graphs must come from argv or --graph
+    for (const string& arg : args) {
+        if (arg == "--stdin") {
+            cerr << "engine: --stdin is not supported, use --graph=<file>" << endl;
+            return nullptr;
+        }
+    }
+    return algo;
+}
+
+// Run the algorithm with its trace going to `out`; returns the exit code
+static int runAlgorithm(const Algorithm* algo, vector<string>& args, FrameStreamBuf& out) {
+    vector<char*> argv;
+    for (string& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    streambuf* previous = cout.rdbuf(&out);
+    int code = algo->run((int)args.size(), argv.data());
+    stepWriter().flush();
+    cout.rdbuf(previous);
+    return code;
+}
+
+/**
+ * Run one request, streaming its trace to `out` as data frames,
+ * and return its exit code. With the cache enabled, a repeated request
+ * replays the stored trace and a new one is stored if it succeeds.
+ */
+static int runRequest(const string& payload, FrameStreamBuf& out, TraceCache& cache) {
+    vector<string> args;
+    const Algorithm* algo = parseRequest(payload, args);
+    if (!algo) {
+        return 2;
+    }
+
+    string key;
+    bool cached = cache.enabled() && TraceCache::normalize(args, key);
+    if (cached) {
+        if (cache.replay(key, [&](const char* data, size_t size) { out.sputn(data, size); })) {
+            return 0;
+        }
+        cache.startRecording(key);
+        out.recordTo(&cache);
+    }
+
+    int code = runAlgorithm(algo, args, out);
+
+    if (cached) {
+        out.recordTo(nullptr);
+        cache.finishRecording(code == 0 && out.ok());
+    }
+    return code;
+}
+
+#ifndef _WIN32
+/**
+ * Trace Sessions
+ * A session runs one request in a forked child process whose step writer
+ * stops after every page (StepWriter::pageBy) and waits for the next page
+ * request, so the trace is only produced as far as the client reads it.
+ * A waiting child is blocked in a read: it keeps its memory but uses no
+ * CPU.
+ *   @open <id> <algorithm> <args...>   start a session; nothing runs yet.
+ *                                      Responds with an end frame (0, or
+ *                                      2 if the request is invalid)
+ *   @next <id> <steps>                 run the session for up to <steps>
+ *                                      more steps. Responds with their data
+ *                                      frames, then a page frame, or the
+ *                                      end frame with the exit code if the
+ *                                      trace finished (closing the session)
+ *   @close <id>                        stop the session early
+ * Sessions belong to the connection that opened them (at most
+ * MAX_SESSIONS) and are stopped when it closes.
+ */
+class TraceSessions {
+public:
+    static const size_t MAX_SESSIONS = 64;
+
+    TraceSessions(int in, int out) : in(in), out(out) {}
+
+    ~TraceSessions() {
+        for (std::pair<const string, Session>& entry : sessions) {
+            stop(entry.second);
+        }
+    }
+
+    // Handle one command; false when the response could not be written
+    bool handle(const string& payload) {
+        istringstream tokens(payload);
+        string command, id;
+        tokens >> command >> id;
+        map<string, Session>::iterator it = sessions.find(id);
+
+        if (command == "@open" && !id.empty()) {
+            string request;
+            getline(tokens, request, '\0');
+            return writeEnd(out, open(id, request));
+        }
+        if (command == "@next" && it != sessions.end()) {
+            long long steps = 0;
+            tokens >> steps;
+            if (steps > 0 && steps <= UINT32_MAX) {
+                return next(it, (uint32_t)steps);
+            }
+            cerr << "engine: @next needs a step count" << endl;
+            return writeEnd(out, 2);
+        }
+        if (command == "@close" && it != sessions.end()) {
+            stop(it->second);
+            sessions.erase(it);
+            return writeEnd(out, 0);
+        }
+
+        if ((command == "@next" || command == "@close") && !id.empty()) {
+            cerr << "engine: no session '" << id << "'" << endl;
+        } else {
+            cerr << "engine: bad session command '" << payload << "'" << endl;
+        }
+        return writeEnd(out, 2);
+    }
+
+private:
+    struct Session {
+        pid_t pid;
+        int control;        // Page sizes to the child
+        int data;           // Frames from the child
+    };
+
+    int in, out;
+    map<string, Session> sessions;
+    vector<char> relay;
+
+    int open(const string& id, const string& request) {
+        if (sessions.count(id)) {
+            cerr << "engine: session '" << id << "' is already open" << endl;
+            return 2;
+        }
+        if (sessions.size() >= MAX_SESSIONS) {
+            cerr << "engine: too many open sessions" << endl;
+            return 2;
+        }
+
+        vector<string> args;
+        const Algorithm* algo = parseRequest(request, args);
+        if (!algo) {
+            return 2;
+        }
+
+        int control[2], data[2];
+        if (pipe(control) != 0) {
+            perror("engine: pipe");
+            return 1;
+        }
+        if (pipe(data) != 0) {
+            perror("engine: pipe");
+            close(control[0]);
+            close(control[1]);
+            return 1;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Keep only this session's pipes; the client's channel and the
+            // other sessions belong to the parent
+            close(control[1]);
+            close(data[0]);
+            for (std::pair<const string, Session>& entry : sessions) {
+                close(entry.second.control);
+                close(entry.second.data);
+            }
+            int devnull = ::open("/dev/null", O_RDWR);
+            dup2(devnull, in);
+            dup2(devnull, out);
+            _exit(runSession(algo, args, control[0], data[1]));
+        }
+
+        close(control[0]);
+        close(data[1]);
+        if (pid < 0) {
+            perror("engine: fork");
+            close(control[1]);
+            close(data[0]);
+            return 1;
+        }
+        Session session = {pid, control[1], data[0]};
+        sessions[id] = session;
+        return 0;
+    }
+
+    // Child side: run the request, waiting for a page size before each page
+    static int runSession(const Algorithm* algo, vector<string>& args, int control, int data) {
+        char count[4];
+        if (!readExact(control, count, sizeof(count))) return 0;
+
+        FrameStreamBuf trace(data);
+        stepWriter().pageBy(getUint32(count), [control, data]() -> long long {
+            char next[4];
+            if (!writeFrame(data, FRAME_PAGE, nullptr, 0) || !readExact(control, next, sizeof(next))) {
+                _exit(0);
+            }
+            return getUint32(next);
+        });
+        ErrorCapture errors;
+        int code = runAlgorithm(algo, args, trace);
+        writeEnd(data, code, errors.str());
+        return 0;
+    }
+
+    // Parent side: ask for a page and pass the child's frames on
+    bool next(map<string, Session>::iterator it, uint32_t steps) {
+        Session& session = it->second;
+        char count[4];
+        putUint32(count, steps);
+        bool ok = writeAll(session.control, count, sizeof(count));
+
+        char header[8];
+        while (ok && readExact(session.data, header, sizeof(header))) {
+            uint32_t size = getUint32(header);
+            uint32_t kind = getUint32(header + 4);
+            relay.resize(size);
+            if (size > 0 && !readExact(session.data, relay.data(), size)) break;
+
+            if (!writeFrame(out, kind, relay.data(), size)) return false;
+            if (kind == FRAME_PAGE) return true;
+            if (kind == FRAME_END) {
+                stop(session);
+                sessions.erase(it);
+                return true;
+            }
+        }
+
+        cerr << "engine: session '" << it->first << "' died" << endl;
+        stop(session);
+        sessions.erase(it);
+        return writeEnd(out, 1);
+    }
+
+    static void stop(Session& session) {
+        close(session.control);
+        close(session.data);
+        kill(session.pid, SIGKILL);
+        waitpid(session.pid, nullptr, 0);
+    }
+};
+#else
+// Sessions need fork; Windows builds refuse the commands
+class TraceSessions {
+public:
+    TraceSessions(int, int out) : out(out) {}
+
+    bool handle(const string&) {
+        cerr << "engine: trace sessions are not supported on Windows" << endl;
+        return writeEnd(out, 2);
+    }
+
+private:
+    int out;
+};
+#endif
+
+/**
+ * Serve requests from `in`, writing responses to `out`, until EOF.
+ */
+static int serve(int in, int out, TraceCache& cache) {
+    TraceSessions sessions(in, out);
+    char header[4];
+    while (readExact(in, header, sizeof(header))) {
+        uint32_t size = getUint32(header);
+        if (size > MAX_REQUEST_SIZE) {
+            cerr << "engine: request of " << size << " bytes exceeds limit" << endl;
+            return 1;
+        }
+
+        string payload(size, '\0');
+        if (size > 0 && !readExact(in, &payload[0], size)) {
+            cerr << "engine: truncated request" << endl;
+            return 1;
+        }
+
+        if (!payload.empty() && payload[0] == '@') {
+            if (!sessions.handle(payload)) return 1;
+            continue;
+        }
+
+        FrameStreamBuf trace(out);
+        ErrorCapture errors;
+        int code = runRequest(payload, trace, cache);
+        if (!trace.ok() || !writeEnd(out, code, errors.str())) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+static int serveSocket(const char* path, TraceCache& cache) {
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        perror("engine: socket");
+        return 1;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        cerr << "engine: socket path too long" << endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 64) < 0) {
+        perror("engine: bind");
+        return 1;
+    }
+
+    // Reap finished workers automatically
+    signal(SIGCHLD, SIG_IGN);
+
+    while (true) {
+        int conn = accept(listener, nullptr, nullptr);
+        if (conn < 0) continue;
+
+        // Each connection gets its own worker process, so connections are
+        // served in parallel and a crashing algorithm only drops one client.
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            int code = serve(conn, conn, cache);
+            close(conn);
+            _exit(code);
+        }
+        close(conn);
+    }
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    const char* socketPath = nullptr;
+    const char* cacheDir = nullptr;
+    uint64_t cacheSize = TraceCache::DEFAULT_BUDGET;
+    bool usage = false;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "--socket") == 0) {
+            socketPath = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--cache") == 0) {
+            cacheDir = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--cache-size") == 0) {
+            cacheSize = strtoull(argv[++i], nullptr, 10);
+        } else {
+            usage = true;
+        }
+    }
+
+    if (usage) {
+        cerr << "Usage: " << argv[0] << " [--socket <path>] [--cache <dir> [--cache-size <bytes>]]" << endl;
+        return 1;
+    }
+
+#ifndef _WIN32
+    // A client or session that went away shows up as a failed write
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    TraceCache cache;
+    if (cacheDir && !cache.open(cacheDir, cacheSize)) {
+        cerr << "engine: cannot use cache directory " << cacheDir << endl;
+        return 1;
+    }
+
+    if (socketPath) {
+#ifdef _WIN32
+        cerr << "engine: --socket is not supported on Windows" << endl;
+        return 1;
+#else
+        return serveSocket(socketPath, cache);
+#endif
+    }
+
+#ifdef _WIN32
+    _setmode(0, _O_BINARY);
+    _setmode(1, _O_BINARY);
+#endif
+
+    return serve(0, 1, cache);
+}
@@ -1,93 +1,609 @@
 #include <iostream>
 #include <vector>
-#include <climits>
+#include <functional>
+#include <algorithm>
 #include <sstream>
 #include <cstdlib>
+#include <climits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#include "algorithms.h"
+#include "csr_graph.h"
+#include "graph_input.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "parallel.h"
+#include "step_writer.h"
 
 using namespace std;
 
 /**
  * Floyd-Warshall Algorithm
  * Input format: <num_nodes> <edge1_u> <edge1_v> <weight> <edge2_u> <edge2_v> <weight> ...
+ * (edges may instead come from --stdin or a --graph=<file> CSR file, see graph_input.h)
  * Outputs JSON steps for visualization
+ *
+ * --blocked runs the tiled, multithreaded kernel for large graphs
+ * (--block=<tile>, default 64; --threads=<n>). Its min-plus row kernel
+ * uses AVX2 when the CPU has it (--scalar forces the portable loop). The
+ * trace then has one iteration step per k-block instead of the
+ * per-cell check/update steps, followed by the usual final distances;
+ * --keyframes are then written before a k-block starts.
+ *
+ * --johnson computes the same distances without the matrix, for sparse
+ * and large graphs: Johnson's algorithm (see JohnsonAllPairs) in
+ * O(VE log V) time and O(V + E) memory. Its trace is reweight steps
+ * for the Bellman-Ford potentials, then finalize and the final distances
+ * streamed row by row; there are no per-cell steps and no keyframes.
+ *
+ * In every mode a node's distance to itself is 0, whatever self-loop it
+ * has, and a negative cycle (a negative self-loop included) is reported
+ * as a negative_cycle(i, j) step on one of its edges, with no distances.
+ * The matrix modes keep distances in 32-bit cells, so they reject edge
+ * weights beyond +-(2^29 - 1) / (num_nodes - 1).
  */
 
-void outputStep(const string& type, int node1 = -1, int node2 = -1, int node3 = -1, int value = -1) {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
+static void outputStep(const char* type, int node1 = -1, int node2 = -1, int node3 = -1, int value = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
     if (node1 != -1) {
-        cout << ",\"i\":" << node1;
+        out.field("i", node1);
     }
     if (node2 != -1) {
-        cout << ",\"j\":" << node2;
+        out.field("j", node2);
     }
     if (node3 != -1) {
-        cout << ",\"k\":" << node3;
+        out.field("k", node3);
     }
     if (value != -1) {
-        cout << ",\"distance\":" << value;
+        out.field("distance", value);
     }
-    cout << "}" << endl;
+    out.endStep();
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 4) {
+// "No path". Any sum at or above FW_FINITE_LIMIT saturates back to FW_INF
+// and any sum below -FW_FINITE_LIMIT is clamped to it, so no sum of two
+// cells overflows. Edge weights are bounded (see maxWeight) so that every
+// simple path is shorter than FW_FINITE_LIMIT: saturation then only drops
+// sums that can never be shortest, and clamping only happens on a
+// negative cycle, whose distances are not reported.
+static const int FW_INF = 1 << 30;
+static const int FW_FINITE_LIMIT = 1 << 29;
+static const int DEFAULT_BLOCK = 64;
+
+/**
+ * Row-major n x n distance matrix. The stride is rounded up to a whole
+ * number of tiles; padding cells hold FW_INF and never take part in a path.
+ */
+struct DistanceMatrix {
+    int size;
+    int stride;
+    vector<int> cells;
+
+    DistanceMatrix(int n, int block)
+        : size(n), stride((n + block - 1) / block * block),
+          cells((size_t)stride * stride, FW_INF) {}
+
+    int* row(int i) {
+        return &cells[(size_t)i * stride];
+    }
+};
+
+// Keyframe: the whole matrix row by row, -1 for no path
+static void outputKeyframe(Keyframes& keyframes, DistanceMatrix& m) {
+    StepWriter& out = stepWriter();
+    keyframes.begin();
+    out.beginList("distance");
+    for (int i = 0; i < m.size; i++) {
+        const int* row = m.row(i);
+        for (int j = 0; j < m.size; j++) {
+            out.item(row[j] == FW_INF ? -1 : row[j]);
+        }
+    }
+    out.endList();
+    keyframes.end();
+}
+
+// dst[j] = min(dst[j], dik + src[j]) for the `count` cells of a tile row
+typedef void (*RowKernel)(int* dst, const int* src, int dik, int count);
+
+static void relaxRowScalar(int* dst, const int* src, int dik, int count) {
+    for (int j = 0; j < count; j++) {
+        int sum = max(dik + src[j], -FW_FINITE_LIMIT);
+        sum = sum >= FW_FINITE_LIMIT ? FW_INF : sum;
+        dst[j] = sum < dst[j] ? sum : dst[j];
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FW_HAVE_AVX2 1
+
+__attribute__((target("avx2")))
+static void relaxRowAvx2(int* dst, const int* src, int dik, int count) {
+    const __m256i add = _mm256_set1_epi32(dik);
+    const __m256i limit = _mm256_set1_epi32(FW_FINITE_LIMIT - 1);
+    const __m256i floor = _mm256_set1_epi32(-FW_FINITE_LIMIT);
+    const __m256i inf = _mm256_set1_epi32(FW_INF);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i sum = _mm256_add_epi32(add, _mm256_loadu_si256((const __m256i*)(src + j)));
+        sum = _mm256_max_epi32(sum, floor);
+        sum = _mm256_blendv_epi8(sum, inf, _mm256_cmpgt_epi32(sum, limit));
+        __m256i current = _mm256_loadu_si256((const __m256i*)(dst + j));
+        _mm256_storeu_si256((__m256i*)(dst + j), _mm256_min_epi32(current, sum));
+    }
+    relaxRowScalar(dst + j, src + j, dik, count - j);
+}
+#endif
+
+static RowKernel chooseKernel(bool forceScalar) {
+#ifdef FW_HAVE_AVX2
+    if (!forceScalar && __builtin_cpu_supports("avx2")) {
+        return relaxRowAvx2;
+    }
+#endif
+    return relaxRowScalar;
+}
+
+/**
+ * Relax tile (ib, jb) through the vertices of k-block kb. Rows with no
+ * path to k are skipped, so the row kernel itself is branch-free.
+ * Returns the number of (i, j, k) cells relaxed.
+ */
+static long long updateTile(DistanceMatrix& m, int ib, int jb, int kb, int block, RowKernel relax) {
+    int kEnd = (kb + 1) * block, iEnd = (ib + 1) * block;
+    long long rows = 0;
+    for (int k = kb * block; k < kEnd; k++) {
+        const int* src = m.row(k) + jb * block;
+        for (int i = ib * block; i < iEnd; i++) {
+            int* dst = m.row(i);
+            int dik = dst[k];
+            if (dik >= FW_FINITE_LIMIT) continue;
+            relax(dst + jb * block, src, dik, block);
+            rows++;
+        }
+    }
+    return rows * block;
+}
+
+/**
+ * Blocked Floyd-Warshall. For each k-block the diagonal tile is closed
+ * first, then the tiles sharing its row or column (which only read the
+ * diagonal tile), then all remaining tiles (which only read those). The
+ * tiles of the last two phases are independent and run on the pool.
+ */
+static void blockedFloydWarshall(DistanceMatrix& m, int block, WorkerPool& pool, RowKernel relax,
+                                 Keyframes& keyframes) {
+    int blocks = m.stride / block;
+    OpCounters& ops = runMetrics().ops;
+    for (int kb = 0; kb < blocks; kb++) {
+        if (keyframes.due()) {
+            outputKeyframe(keyframes, m);
+        }
+        outputStep("iteration", -1, -1, kb * block);
+
+        ops.relaxations += updateTile(m, kb, kb, kb, block, relax);
+
+        pool.parallelFor((size_t)blocks * 2, 1, [&](size_t begin, size_t end, int) {
+            long long relaxed = 0;
+            for (size_t t = begin; t < end; t++) {
+                int other = (int)(t / 2);
+                if (other == kb) continue;
+                if (t % 2 == 0) {
+                    relaxed += updateTile(m, kb, other, kb, block, relax);
+                } else {
+                    relaxed += updateTile(m, other, kb, kb, block, relax);
+                }
+            }
+            Metrics::countShared(ops.relaxations, relaxed);
+        });
+
+        pool.parallelFor((size_t)blocks * blocks, 1, [&](size_t begin, size_t end, int) {
+            long long relaxed = 0;
+            for (size_t t = begin; t < end; t++) {
+                int ib = (int)(t / blocks), jb = (int)(t % blocks);
+                if (ib == kb || jb == kb) continue;
+                relaxed += updateTile(m, ib, jb, kb, block, relax);
+            }
+            Metrics::countShared(ops.relaxations, relaxed);
+        });
+    }
+}
+
+// Rows of Dijkstra results held at once before they are written, in cells
+static const size_t JOHNSON_CHUNK_CELLS = 1 << 22;
+
+/**
+ * Johnson's all-pairs shortest paths. A Bellman-Ford pass from a virtual
+ * source with a 0-weight edge to every node gives potentials h with
+ * w(u, v) + h[u] - h[v] >= 0 on every edge (or finds a negative cycle).
+ * A Dijkstra from every source on those reweighted edges then gives
+ * d(s, t) = d'(s, t) - h[s] + h[t].
+ *
+ * The sources are split across the worker pool a chunk at a time. Each
+ * worker keeps its own distance array and heap, and each finished row
+ * holds only the reached nodes. A chunk's rows are written in source
+ * order once it is done, so the trace is the same for any thread count
+ * and memory stays O(V + E) plus one chunk of rows.
+ *
+ * Edges follow the matrix's rules: for repeated (u, v) pairs the last
+ * weight counts, and edges with an endpoint outside the graph are
+ * dropped. A node's distance to itself is 0, so a self-loop only counts
+ * when it is negative, as a negative cycle.
+ */
+class JohnsonAllPairs {
+public:
+    JohnsonAllPairs(const CsrGraph& graph, WorkerPool& pool) : n(graph.numNodes), pool(pool) {
+        keepLastArcs(graph);
+    }
+
+    /**
+     * Compute the potentials; false if there is a negative cycle, with
+     * one of its edges in cycleFrom -> cycleTo.
+     */
+    bool reweight(int& cycleFrom, int& cycleTo) {
+        potential.assign(n, 0);
+        bool negative = false;
+        for (int w : weights) {
+            negative = negative || w < 0;
+        }
+        if (!negative) return true;
+
+        // With the virtual source there are n + 1 nodes, so n passes settle
+        // every shortest path; one that still changes means a cycle
+        OpCounters& ops = runMetrics().ops;
+        for (int pass = 0; pass <= n; pass++) {
+            bool changed = false;
+            for (int u = 0; u < n; u++) {
+                for (int64_t a = offsets[u]; a < offsets[u + 1]; a++) {
+                    long long candidate = potential[u] + weights[a];
+                    if (candidate < potential[targets[a]]) {
+                        if (pass == n) {
+                            cycleFrom = u;
+                            cycleTo = targets[a];
+                            return false;
+                        }
+                        potential[targets[a]] = candidate;
+                        changed = true;
+                    }
+                }
+            }
+            ops.relaxations += (long long)targets.size();
+            if (!changed) break;
+        }
+        return true;
+    }
+
+    long long potentialOf(int node) const {
+        return potential[node];
+    }
+
+    /**
+     * Run the Dijkstras, calling emit(source, row) for every source in
+     * order; row lists (node, distance) for the reached nodes by node.
+     */
+    void allPairs(const std::function<void(int, const vector<pair<int, int>>&)>& emit) {
+        vector<Worker> workers(pool.size());
+        for (Worker& worker : workers) {
+            worker.dist.assign(n, LLONG_MAX);
+        }
+
+        size_t chunk = min((size_t)n, max((size_t)pool.size(), JOHNSON_CHUNK_CELLS / max(1, n)));
+        vector<vector<pair<int, int>>> rows(chunk);
+        for (size_t first = 0; first < (size_t)n; first += chunk) {
+            size_t count = min(chunk, (size_t)n - first);
+            pool.parallelFor(count, 1, [&](size_t begin, size_t end, int w) {
+                for (size_t r = begin; r < end; r++) {
+                    shortestPaths(workers[w], (int)(first + r), rows[r]);
+                }
+            });
+            for (size_t r = 0; r < count; r++) {
+                emit((int)(first + r), rows[r]);
+                rows[r].clear();
+            }
+        }
+
+        OpCounters& ops = runMetrics().ops;
+        for (const Worker& worker : workers) {
+            ops.relaxations += worker.relaxations;
+            ops.pushes += worker.pushes;
+            ops.pops += worker.pops;
+            ops.stalePops += worker.stalePops;
+        }
+    }
+
+private:
+    // Per-thread Dijkstra state; dist is reset through `reached` only
+    struct Worker {
+        vector<long long> dist;
+        vector<int> reached;
+        vector<pair<long long, int>> heap;
+        long long relaxations = 0, pushes = 0, pops = 0, stalePops = 0;
+    };
+
+    typedef greater<pair<long long, int>> Greater;
+
+    int n;
+    WorkerPool& pool;
+    vector<int64_t> offsets;
+    vector<int> targets;
+    vector<int> weights;
+    vector<long long> potential;
+
+    // Copy the arcs, keeping only the last of each repeated (u, v)
+    void keepLastArcs(const CsrGraph& graph) {
+        vector<int64_t> last(n, -1);
+        offsets.assign(n + 1, 0);
+        targets.reserve(graph.numArcs);
+        weights.reserve(graph.numArcs);
+        for (int u = 0; u < n; u++) {
+            for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+                last[graph.targets[a]] = a;
+            }
+            for (int64_t a = graph.arcBegin(u); a < graph.arcEnd(u); a++) {
+                if (last[graph.targets[a]] != a) continue;
+                targets.push_back(graph.targets[a]);
+                weights.push_back(graph.weights[a]);
+            }
+            offsets[u + 1] = (int64_t)targets.size();
+        }
+    }
+
+    void shortestPaths(Worker& worker, int source, vector<pair<int, int>>& row) {
+        vector<long long>& dist = worker.dist;
+        vector<pair<long long, int>>& heap = worker.heap;
+        worker.reached.clear();
+
+        dist[source] = 0;
+        worker.reached.push_back(source);
+        heap.push_back(make_pair(0LL, source));
+        worker.pushes++;
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), Greater());
+            long long d = heap.back().first;
+            int u = heap.back().second;
+            heap.pop_back();
+            worker.pops++;
+            if (d > dist[u]) {
+                worker.stalePops++;
+                continue;
+            }
+
+            long long hu = potential[u];
+            for (int64_t a = offsets[u]; a < offsets[u + 1]; a++) {
+                int v = targets[a];
+                long long candidate = d + weights[a] + hu - potential[v];
+                worker.relaxations++;
+                if (candidate < dist[v]) {
+                    if (dist[v] == LLONG_MAX) worker.reached.push_back(v);
+                    dist[v] = candidate;
+                    heap.push_back(make_pair(candidate, v));
+                    push_heap(heap.begin(), heap.end(), Greater());
+                    worker.pushes++;
+                }
+            }
+        }
+
+        sort(worker.reached.begin(), worker.reached.end());
+        long long hs = potential[source];
+        for (int v : worker.reached) {
+            row.push_back(make_pair(v, (int)(dist[v] - hs + potential[v])));
+            dist[v] = LLONG_MAX;
+        }
+    }
+};
+
+/**
+ * --johnson: all pairs without the matrix; see JohnsonAllPairs.
+ */
+static void runJohnson(const GraphInput& input, const Options& opts) {
+    Metrics& metrics = runMetrics();
+    StepWriter& out = stepWriter();
+    out.declareSteps({"reweight"}, "i j k distance", TRACE_EVENTS);
+
+    metrics.phase(PHASE_BUILD);
+    CsrGraph graph;
+    graph.build(input, CSR_WEIGHTED);
+    WorkerPool pool(threadCount(opts));
+    JohnsonAllPairs johnson(graph, pool);
+
+    outputStep("initialize");
+    metrics.phase(PHASE_RUN);
+
+    int cycleFrom = -1, cycleTo = -1;
+    if (!johnson.reweight(cycleFrom, cycleTo)) {
+        metrics.phase(PHASE_EMIT);
+        outputStep("negative_cycle", cycleFrom, cycleTo);
+        return;
+    }
+    if (out.emits(TRACE_EVENTS)) {
+        for (int v = 0; v < graph.numNodes; v++) {
+            if (johnson.potentialOf(v) != 0) {
+                outputStep("reweight", v, -1, -1, (int)johnson.potentialOf(v));
+            }
+        }
+    }
+
+    outputStep("finalize");
+    johnson.allPairs([](int source, const vector<pair<int, int>>& row) {
+        for (const pair<int, int>& cell : row) {
+            outputStep("final_distance", source, cell.first, -1, cell.second);
+        }
+    });
+    metrics.phase(PHASE_EMIT);
+}
+
+/**
+ * Largest edge weight magnitude the matrix kernels take for n nodes: a
+ * simple path has at most n - 1 edges, so its length stays within
+ * FW_FINITE_LIMIT.
+ */
+static int maxWeight(int numNodes) {
+    return (FW_FINITE_LIMIT - 1) / max(1, numNodes - 1);
+}
+
+/**
+ * After either kernel a node on a negative cycle has a negative distance
+ * to itself, and with no negative cycle the diagonal stays 0. Which
+ * cells go negative depends on the kernel's order, so the reported edge
+ * comes from the Bellman-Ford pass --johnson uses. Returns false if
+ * there is no negative cycle.
+ */
+static bool outputNegativeCycle(DistanceMatrix& dist, const GraphInput& input) {
+    bool negative = false;
+    for (int i = 0; i < dist.size && !negative; i++) {
+        negative = dist.row(i)[i] < 0;
+    }
+    if (!negative) return false;
+
+    CsrGraph graph;
+    graph.build(input, CSR_WEIGHTED);
+    WorkerPool pool(1);
+    JohnsonAllPairs johnson(graph, pool);
+    int cycleFrom = -1, cycleTo = -1;
+    johnson.reweight(cycleFrom, cycleTo);
+    outputStep("negative_cycle", cycleFrom, cycleTo);
+    return true;
+}
+
+int runFloydWarshall(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
+    if (argc < 2) {
         cerr << "Usage: " << argv[0] << " <num_nodes> <edge1_u> <edge1_v> <weight> ..." << endl;
         return 1;
     }
 
-    int numNodes = atoi(argv[1]);
+    GraphInput input;
+    if (!loadGraph(opts, argc, argv, 2, true, input)) {
+        return 1;
+    }
+
+    if (!opts.has("johnson")) {
+        int numNodes = input.numNodes, limit = maxWeight(numNodes);
+        bool inRange = true;
+        input.forEachEdge([&](int u, int v, int weight) {
+            if (inRange && u >= 0 && u < numNodes && v >= 0 && v < numNodes &&
+                (weight > limit || weight < -limit)) {
+                cerr << "Edge weight " << weight << " on " << u << " -> " << v << " is out of range: with "
+                     << numNodes << " nodes weights must be within +-" << limit << endl;
+                inRange = false;
+            }
+        });
+        if (!inRange) {
+            return 1;
+        }
+    }
+
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"initialize", "iteration"}, "i j k distance", TRACE_SUMMARY);
+    out.declareSteps({"check"}, "i j k distance");
+    out.declareSteps({"update"}, "i j k distance", TRACE_EVENTS);
+    out.declareSteps({"finalize"}, "i j k distance", TRACE_SUMMARY);
+    out.declareSteps({"final_distance"}, "i j k distance", TRACE_RESULT);
+    out.declareSteps({"negative_cycle"}, "i j k distance", TRACE_RESULT);
+    Keyframes keyframes(opts);
+
+    if (opts.has("johnson")) {
+        runJohnson(input, opts);
+        finishMetrics();
+        return 0;
+    }
+
+    int numNodes = input.numNodes;
+    // With nothing traced per iteration the blocked kernel takes over. Within
+    // the weight bound both kernels give exact distances, so verbosity only
+    // changes what is written (algorithm_bench --check compares the two)
+    bool blocked = opts.has("blocked") || !out.emits(TRACE_SUMMARY);
+    int block = (int)max(8LL, opts.getInt("block", DEFAULT_BLOCK)) / 8 * 8;
     
-    vector<vector<int>> dist(numNodes, vector<int>(numNodes, INT_MAX));
+    metrics.phase(PHASE_BUILD);
+    DistanceMatrix dist(numNodes, blocked ? block : 1);
     
     // Initialize diagonal to 0
     for (int i = 0; i < numNodes; i++) {
-        dist[i][i] = 0;
+        dist.row(i)[i] = 0;
     }
     
-    // Parse edges with weights
-    for (int i = 2; i < argc; i += 3) {
-        if (i + 2 < argc) {
-            int u = atoi(argv[i]);
-            int v = atoi(argv[i + 1]);
-            int weight = atoi(argv[i + 2]);
-            if (u >= 0 && u < numNodes && v >= 0 && v < numNodes) {
-                dist[u][v] = weight;
-            }
+    // Set directed edge weights
+    input.forEachEdge([&](int u, int v, int weight) {
+        if (u >= 0 && u < numNodes && v >= 0 && v < numNodes) {
+            dist.row(u)[v] = weight;
         }
+    });
+
+    // A self-loop never shortens the empty path, unless it is negative and
+    // so a negative cycle (as in --johnson)
+    for (int i = 0; i < numNodes; i++) {
+        dist.row(i)[i] = min(dist.row(i)[i], 0);
     }
     
     outputStep("initialize");
+    metrics.phase(PHASE_RUN);
     
-    // Floyd-Warshall algorithm
-    for (int k = 0; k < numNodes; k++) {
-        outputStep("iteration", -1, -1, k);
-        
-        for (int i = 0; i < numNodes; i++) {
-            for (int j = 0; j < numNodes; j++) {
-                if (dist[i][k] != INT_MAX && dist[k][j] != INT_MAX) {
-                    int newDist = dist[i][k] + dist[k][j];
-                    outputStep("check", i, j, k, newDist);
-                    
-                    if (newDist < dist[i][j]) {
-                        dist[i][j] = newDist;
-                        outputStep("update", i, j, -1, dist[i][j]);
+    if (blocked) {
+        WorkerPool pool(threadCount(opts));
+        blockedFloydWarshall(dist, block, pool, chooseKernel(opts.has("scalar")), keyframes);
+    } else {
+        // Floyd-Warshall algorithm
+        for (int k = 0; k < numNodes; k++) {
+            outputStep("iteration", -1, -1, k);
+            const int* rowK = dist.row(k);
+            
+            for (int i = 0; i < numNodes; i++) {
+                int* rowI = dist.row(i);
+                for (int j = 0; j < numNodes; j++) {
+                    if (rowI[k] != FW_INF && rowK[j] != FW_INF) {
+                        int newDist = max(rowI[k] + rowK[j], -FW_FINITE_LIMIT);
+                        metrics.ops.relaxations++;
+                        if (out.emits(TRACE_FULL)) {
+                            outputStep("check", i, j, k, newDist);
+                        }
+                        
+                        if (newDist < rowI[j]) {
+                            rowI[j] = newDist;
+                            if (out.emits(TRACE_EVENTS)) {
+                                outputStep("update", i, j, -1, rowI[j]);
+                            }
+                        }
                     }
                 }
+                if (keyframes.due()) {
+                    outputKeyframe(keyframes, dist);
+                }
             }
         }
     }
     
     // Output final distances
+    metrics.phase(PHASE_EMIT);
+    if (outputNegativeCycle(dist, input)) {
+        finishMetrics();
+        return 0;
+    }
     outputStep("finalize");
     for (int i = 0; i < numNodes; i++) {
+        const int* row = dist.row(i);
         for (int j = 0; j < numNodes; j++) {
-            if (dist[i][j] != INT_MAX) {
-                outputStep("final_distance", i, j, -1, dist[i][j]);
+            if (row[j] != FW_INF) {
+                outputStep("final_distance", i, j, -1, row[j]);
             }
         }
     }
 
+    finishMetrics();
+
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runFloydWarshall(argc, argv);
+}
+#endif
+
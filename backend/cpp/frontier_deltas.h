@@ -0,0 +1,84 @@
+#ifndef FRONTIER_DELTAS_H
+#define FRONTIER_DELTAS_H
+
+#include <algorithm>
+
+#include "options.h"
+#include "step_writer.h"
+
+/**
+ * Frontier Deltas
+ * With --queue-deltas, BFS, DFS and Dijkstra describe their queue or
+ * stack as push/pop/decrease steps instead of a full snapshot after every
+ * change:
+ *   queue_push(node[, distance]), queue_pop(node),
+ *   queue_decrease(node, distance), stack_push(node), stack_pop(node)
+ * A full snapshot (the usual queue/priority_queue/stack step) is still
+ * emitted once the deltas since the last one reach
+ * max(--snapshot-every, frontier size), default 64. Snapshot cost is
+ * therefore O(1) amortized per operation, and a consumer can rebuild the
+ * frontier from any snapshot plus the deltas after it.
+ */
+
+class FrontierDeltas {
+public:
+    enum Kind { QUEUE, STACK };
+
+    FrontierDeltas(const Options& opts, Kind kind)
+        : enabled(opts.has("queue-deltas")),
+          interval((size_t)std::max(1LL, opts.getInt("snapshot-every", 64))),
+          pending(0),
+          pushType(kind == QUEUE ? "queue_push" : "stack_push"),
+          popType(kind == QUEUE ? "queue_pop" : "stack_pop") {
+        if (enabled) {
+            stepWriter().declareSteps({pushType, popType, "queue_decrease"}, "node distance");
+        }
+    }
+
+    const bool enabled;
+
+    void push(int node) {
+        emit(pushType, node, -1);
+    }
+
+    void push(int node, int distance) {
+        emit(pushType, node, distance);
+    }
+
+    void pop(int node) {
+        emit(popType, node, -1);
+    }
+
+    void decrease(int node, int distance) {
+        emit("queue_decrease", node, distance);
+    }
+
+    /**
+     * True when a full snapshot should be written now; resets the count.
+     */
+    bool snapshotDue(size_t frontierSize) {
+        if (pending < std::max(interval, frontierSize)) return false;
+        pending = 0;
+        return true;
+    }
+
+private:
+    size_t interval;
+    size_t pending;
+    const char* pushType;
+    const char* popType;
+
+    void emit(const char* type, int node, int distance) {
+        StepWriter& out = stepWriter();
+        out.beginStep(type);
+        out.field("node", node);
+        if (distance != -1) {
+            out.field("distance", distance);
+        }
+        out.endStep();
+        pending++;
+    }
+};
+
+#endif
+
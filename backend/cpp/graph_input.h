@@ -0,0 +1,279 @@
+#ifndef GRAPH_INPUT_H
+#define GRAPH_INPUT_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "options.h"
+
+/**
+ * Graph Input
+ * Loads the edges of a graph program from one of three sources:
+ *   default          edge tokens on the command line after the header
+ *                    arguments: <u> <v> [<weight>] ...
+ *   --stdin          the same whitespace-separated edge tokens, read from
+ *                    stdin (no ARG_MAX limit); not available in the engine
+ *   --graph=<file>   a binary CSR graph file, memory-mapped without parsing
+ *
+ * CSR file layout (little-endian, written by csr_convert):
+ *   char     magic[4] = "ACSR"
+ *   uint32   version = 1
+ *   uint32   flags (bit 0: weighted)
+ *   uint32   numNodes
+ *   uint64   numArcs
+ *   int64    offsets[numNodes + 1]   arcs of u are offsets[u]..offsets[u+1]
+ *   int32    targets[numArcs]
+ *   int32    weights[numArcs]        only when weighted
+ * The file stores arcs exactly as traversed, so an undirected graph holds
+ * each edge in both directions. <num_nodes> on the command line must match
+ * the file.
+ */
+
+struct EdgeList {
+    std::vector<int> u, v, w;   // Struct of arrays; w is empty when unweighted
+
+    size_t size() const {
+        return u.size();
+    }
+};
+
+static const uint32_t CSR_FILE_WEIGHTED = 1;
+static const size_t CSR_HEADER_SIZE = 24;
+
+class GraphInput {
+public:
+    int numNodes;
+    EdgeList edges;             // Edges from the command line or stdin
+
+    // Mapped CSR arrays (null unless loaded with --graph)
+    const int64_t* offsets;
+    const int32_t* targets;
+    const int32_t* weights;
+    int64_t numArcs;
+
+    GraphInput()
+        : numNodes(0), offsets(nullptr), targets(nullptr), weights(nullptr), numArcs(0),
+          mapping(nullptr), mappingSize(0) {}
+
+    ~GraphInput() {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, mappingSize);
+#endif
+    }
+
+    /**
+     * True when the graph came from a CSR file. Its arcs already hold both
+     * directions of an undirected edge, so callers must not mirror them.
+     */
+    bool isCsr() const {
+        return offsets != nullptr;
+    }
+
+    /**
+     * Call fn(u, v, weight) for every edge (or CSR arc); weight is 1 for
+     * unweighted input.
+     */
+    template <typename Fn>
+    void forEachEdge(Fn fn) const {
+        if (isCsr()) {
+            for (int u = 0; u < numNodes; u++) {
+                for (int64_t a = offsets[u]; a < offsets[u + 1]; a++) {
+                    fn(u, targets[a], weights ? weights[a] : 1);
+                }
+            }
+            return;
+        }
+        bool weighted = !edges.w.empty();
+        for (size_t e = 0; e < edges.size(); e++) {
+            fn(edges.u[e], edges.v[e], weighted ? edges.w[e] : 1);
+        }
+    }
+
+    /**
+     * Map a CSR file. Returns false and prints a message on failure.
+     */
+    bool mapCsr(const std::string& path) {
+        const char* data = nullptr;
+        size_t size = 0;
+
+#ifndef _WIN32
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) < 0) {
+            std::cerr << "Cannot open graph file " << path << std::endl;
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+        if (size > 0) {
+            mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED || size == 0) {
+            mapping = nullptr;
+            std::cerr << "Cannot map graph file " << path << std::endl;
+            return false;
+        }
+        mappingSize = size;
+        data = (const char*)mapping;
+#else
+        // No mmap on Windows: read the file into memory instead
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            std::cerr << "Cannot open graph file " << path << std::endl;
+            return false;
+        }
+        char chunk[1 << 16];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            storage.insert(storage.end(), chunk, chunk + n);
+        }
+        fclose(file);
+        data = storage.data();
+        size = storage.size();
+#endif
+
+        uint32_t header[3];
+        uint64_t arcs = 0;
+        if (size < CSR_HEADER_SIZE || memcmp(data, "ACSR", 4) != 0) {
+            std::cerr << "Not a CSR graph file: " << path << std::endl;
+            return false;
+        }
+        memcpy(header, data + 4, sizeof(header));
+        memcpy(&arcs, data + 16, sizeof(arcs));
+
+        // Counts beyond the file size are rejected before they can overflow
+        uint32_t version = header[0], flags = header[1], nodes = header[2];
+        bool fits = nodes < (uint32_t)INT32_MAX && arcs <= size / sizeof(int32_t);
+        size_t expected = !fits ? 0 : CSR_HEADER_SIZE + ((size_t)nodes + 1) * sizeof(int64_t) +
+                                      arcs * sizeof(int32_t) * ((flags & CSR_FILE_WEIGHTED) ? 2 : 1);
+        if (version != 1 || !fits || size < expected) {
+            std::cerr << "Unsupported or truncated CSR graph file: " << path << std::endl;
+            return false;
+        }
+
+        const int64_t* fileOffsets = (const int64_t*)(data + CSR_HEADER_SIZE);
+        const int32_t* fileTargets = (const int32_t*)(fileOffsets + nodes + 1);
+        if (!validCsr(fileOffsets, fileTargets, nodes, (int64_t)arcs)) {
+            std::cerr << "Corrupt CSR graph file (offsets or targets out of range): " << path << std::endl;
+            return false;
+        }
+
+        numNodes = (int)nodes;
+        numArcs = (int64_t)arcs;
+        offsets = fileOffsets;
+        targets = fileTargets;
+        weights = (flags & CSR_FILE_WEIGHTED) ? targets + arcs : nullptr;
+        return true;
+    }
+
+private:
+    void* mapping;
+    size_t mappingSize;
+
+    // Offsets run from 0 to arcs without decreasing, and every target is a node
+    static bool validCsr(const int64_t* offsets, const int32_t* targets, uint32_t nodes, int64_t arcs) {
+        if (offsets[0] != 0 || offsets[nodes] != arcs) return false;
+        for (uint32_t u = 0; u < nodes; u++) {
+            if (offsets[u + 1] < offsets[u]) return false;
+        }
+        for (int64_t a = 0; a < arcs; a++) {
+            if (targets[a] < 0 || (uint32_t)targets[a] >= nodes) return false;
+        }
+        return true;
+    }
+    std::vector<char> storage;
+
+    GraphInput(const GraphInput&);
+    GraphInput& operator=(const GraphInput&);
+};
+
+/**
+ * Read every integer from a stream (whitespace separated) without
+ * going through iostreams.
+ */
+inline std::vector<int> readIntTokens(FILE* in) {
+    std::vector<int> tokens;
+    char chunk[1 << 16];
+    long long value = 0;
+    bool negative = false, inNumber = false;
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            char c = chunk[i];
+            if (c >= '0' && c <= '9') {
+                value = value * 10 + (c - '0');
+                inNumber = true;
+            } else if (c == '-' && !inNumber) {
+                negative = true;
+            } else {
+                if (inNumber) tokens.push_back((int)(negative ? -value : value));
+                value = 0;
+                negative = inNumber = false;
+            }
+        }
+    }
+    if (inNumber) tokens.push_back((int)(negative ? -value : value));
+    return tokens;
+}
+
+/**
+ * Load a graph whose edge tokens start at argv[firstEdgeArg] (or come
+ * from stdin / a CSR file, see above). Edge endpoints are not validated
+ * here; callers apply their own checks. Returns false and prints a
+ * message on failure.
+ */
+inline bool loadGraph(const Options& opts, int argc, char* argv[], int firstEdgeArg,
+                      bool weighted, GraphInput& graph) {
+    graph.numNodes = atoi(argv[1]);
+
+    if (opts.has("graph")) {
+        int expected = graph.numNodes;
+        if (!graph.mapCsr(opts.get("graph"))) return false;
+        if (graph.numNodes != expected) {
+            std::cerr << "num_nodes is " << expected << " but the graph file has "
+                      << graph.numNodes << " nodes" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    int width = weighted ? 3 : 2;
+    EdgeList& edges = graph.edges;
+
+    if (opts.has("stdin")) {
+        std::vector<int> tokens = readIntTokens(stdin);
+        size_t count = tokens.size() / width;
+        edges.u.reserve(count);
+        edges.v.reserve(count);
+        if (weighted) edges.w.reserve(count);
+        for (size_t t = 0; t + width <= tokens.size(); t += width) {
+            edges.u.push_back(tokens[t]);
+            edges.v.push_back(tokens[t + 1]);
+            if (weighted) edges.w.push_back(tokens[t + 2]);
+        }
+        return true;
+    }
+
+    for (int i = firstEdgeArg; i + width - 1 < argc; i += width) {
+        edges.u.push_back(atoi(argv[i]));
+        edges.v.push_back(atoi(argv[i + 1]));
+        if (weighted) edges.w.push_back(atoi(argv[i + 2]));
+    }
+    return true;
+}
+
+#endif
+
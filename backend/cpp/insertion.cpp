@@ -3,6 +3,12 @@
 #include <sstream>
 #include <cstdlib>
 
+#include "algorithms.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "step_writer.h"
+
 using namespace std;
 
 /**
@@ -10,25 +16,34 @@ using namespace std;
  * Outputs JSON steps for visualization
  */
 
-void outputStep(const string& type, int i, int j = -1, int value = -1) {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
-    cout << ",\"i\":" << i;
+static void outputStep(const char* type, int i, int j = -1, int value = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
+    out.field("i", i);
     if (j != -1) {
-        cout << ",\"j\":" << j;
+        out.field("j", j);
     }
     if (value != -1) {
-        cout << ",\"value\":" << value;
+        out.field("value", value);
     }
-    cout << "}" << endl;
+    out.endStep();
 }
 
-int main(int argc, char* argv[]) {
+int runInsertionSort(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
     if (argc < 2) {
         cerr << "Usage: " << argv[0] << " <numbers>" << endl;
         return 1;
     }
 
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"compare"}, "i j value");
+    out.declareSteps({"overwrite"}, "i j value", TRACE_EVENTS);
+    out.declareSteps({"sorted"}, "i j value", TRACE_RESULT);
+    Keyframes keyframes(opts);
+
     vector<int> arr;
     
     for (int i = 1; i < argc; i++) {
@@ -36,6 +51,8 @@ int main(int argc, char* argv[]) {
     }
 
     int n = arr.size();
+    OpCounters& ops = metrics.ops;
+    metrics.phase(PHASE_RUN);
     
     // Insertion Sort
     for (int i = 1; i < n; i++) {
@@ -45,30 +62,56 @@ int main(int argc, char* argv[]) {
         // Compare and shift elements
         while (j >= 0) {
             // Compare step
-            outputStep("compare", j, i);
+            if (out.emits(TRACE_FULL)) {
+                outputStep("compare", j, i);
+            }
+            ops.comparisons++;
             
             if (arr[j] > key) {
                 // Overwrite step (shifting element)
-                outputStep("overwrite", j + 1, -1, arr[j]);
+                if (out.emits(TRACE_EVENTS)) {
+                    outputStep("overwrite", j + 1, -1, arr[j]);
+                }
                 arr[j + 1] = arr[j];
+                ops.overwrites++;
                 j--;
             } else {
                 break;
             }
+            if (keyframes.due()) {
+                keyframes.begin();
+                keyframes.list("array", arr);
+                keyframes.end();
+            }
         }
         
         // Insert key at correct position
         if (j + 1 != i) {
             outputStep("overwrite", j + 1, -1, key);
             arr[j + 1] = key;
+            ops.overwrites++;
+        }
+        if (keyframes.due()) {
+            keyframes.begin();
+            keyframes.list("array", arr);
+            keyframes.end();
         }
     }
     
     // Mark all elements as sorted
+    metrics.phase(PHASE_EMIT);
     for (int i = 0; i < n; i++) {
         outputStep("sorted", i);
     }
 
+    finishMetrics();
+
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runInsertionSort(argc, argv);
+}
+#endif
+
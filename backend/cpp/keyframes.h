@@ -0,0 +1,98 @@
+#ifndef KEYFRAMES_H
+#define KEYFRAMES_H
+
+#include <algorithm>
+#include <vector>
+
+#include "options.h"
+#include "step_writer.h"
+
+/**
+ * Keyframes
+ * With --keyframes[=<k>] (default 1024) a program writes a keyframe step
+ * holding its whole state about every k steps, plus an index of where
+ * each keyframe starts (see StepWriter::finishTrace). To show step s, a
+ * consumer seeks to the last keyframe at or before s and applies the
+ * steps after it, at most about k of them, instead of replaying the trace
+ * from the start.
+ *
+ * keyframe(array[], visited[], reverse_visited[], distance[], frontier[]),
+ * each field optional:
+ *   array      the array (sorts)
+ *   visited    nodes marked visited, in node order
+ *   reverse_visited  nodes settled by the reverse side of a bidirectional
+ *              Dijkstra, in node order
+ *   distance   tentative distance of every node (-1 for unreached);
+ *              Floyd-Warshall writes the whole matrix row by row
+ *   frontier   the nodes in the queue, stack or priority queue, in the
+ *              order its snapshot step lists them (without stale heap
+ *              entries)
+ * The state is the one right after the step before the keyframe, so with
+ * the full trace it equals the result of replaying every earlier step.
+ * Keyframes are result-level steps: a lower verbosity or a step budget
+ * drops deltas but never keyframes, which keep showing the true state.
+ *
+ * Usage:
+ *   Keyframes keyframes(opts);      // after startTrace, with the other declarations
+ *   if (keyframes.due()) {          // wherever the state matches the trace
+ *       keyframes.begin();
+ *       keyframes.list("array", arr);
+ *       keyframes.end();
+ *   }
+ */
+
+class Keyframes {
+public:
+    explicit Keyframes(const Options& opts)
+        : enabled(opts.has("keyframes")),
+          interval(std::max(1LL, opts.getInt("keyframes", 1024))),
+          next(interval) {
+        if (enabled) {
+            StepWriter& out = stepWriter();
+            out.declareSteps({"keyframe"}, "array[] visited[] reverse_visited[] distance[] frontier[]", TRACE_RESULT);
+            out.indexKeyframes();
+        }
+    }
+
+    const bool enabled;
+
+    // True when at least k steps were written since the last keyframe
+    bool due() const {
+        return enabled && stepWriter().stepCount() >= next;
+    }
+
+    void begin() {
+        stepWriter().beginKeyframe("keyframe");
+    }
+
+    void list(const char* key, const std::vector<int>& values) {
+        StepWriter& out = stepWriter();
+        out.beginList(key);
+        for (int value : values) {
+            out.item(value);
+        }
+        out.endList();
+    }
+
+    // The indices of the marked entries, e.g. the visited nodes
+    void marked(const char* key, const std::vector<bool>& marks) {
+        StepWriter& out = stepWriter();
+        out.beginList(key);
+        for (size_t i = 0; i < marks.size(); i++) {
+            if (marks[i]) out.item((long long)i);
+        }
+        out.endList();
+    }
+
+    void end() {
+        StepWriter& out = stepWriter();
+        out.endStep();
+        next = out.stepCount() + interval;
+    }
+
+private:
+    long long interval;
+    long long next;
+};
+
+#endif
@@ -2,90 +2,311 @@
 #include <vector>
 #include <sstream>
 #include <cstdlib>
+#include <algorithm>
+#include <memory>
+
+#include "algorithms.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "parallel.h"
+#include "step_writer.h"
 
 using namespace std;
 
 /**
  * Merge Sort Algorithm
  * Outputs JSON steps for visualization
+ * Merges go through one scratch buffer allocated up front.
+ *   --natural      bottom-up merge of the input's existing ascending runs
+ *                  (found with one scan of compare steps), ping-ponging
+ *                  between the array and the scratch buffer
+ *   --parallel     sort and merge as tasks on --threads=<n> work-stealing
+ *                  workers; the trace is identical to the sequential one
+ *                  but is held in memory until the sort finishes; a
+ *                  --max-steps budget is spent in trace order,
+ *                  --keyframes need the array as the trace leaves it and
+ *                  a paged trace (engine sessions) is suspended between
+ *                  steps, so with any of them it runs the sequential sort
  */
 
-void outputStep(const string& type, int i, int j = -1, int value = -1) {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
-    cout << ",\"i\":" << i;
+// Ranges at most this long are sorted by one task without splitting
+static const int SORT_GRAIN = 4096;
+// Merges of at most this many elements are not split further
+static const int MERGE_GRAIN = 8192;
+
+static void outputStep(StepWriter& out, const char* type, int i, int j = -1, int value = -1) {
+    out.beginStep(type);
+    out.field("i", i);
     if (j != -1) {
-        cout << ",\"j\":" << j;
+        out.field("j", j);
     }
     if (value != -1) {
-        cout << ",\"value\":" << value;
+        out.field("value", value);
     }
-    cout << "}" << endl;
+    out.endStep();
 }
 
-void merge(vector<int>& arr, int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-    
-    vector<int> L(n1), R(n2);
-    
-    for (int i = 0; i < n1; i++) {
-        L[i] = arr[left + i];
+/**
+ * A slice of one merge: src[i, iEnd) and src[j, jEnd) go to arr from k on.
+ * mid and right bound the halves of the whole merge; the trace compares
+ * whenever both halves still have elements, exactly as the unsplit merge
+ * of arr[left..mid] and arr[mid+1..right] would.
+ */
+struct MergeSpan {
+    int i, iEnd;
+    int j, jEnd;
+    int k;
+    int mid, right;
+
+    int length() const {
+        return (iEnd - i) + (jEnd - j);
     }
-    for (int j = 0; j < n2; j++) {
-        R[j] = arr[mid + 1 + j];
+};
+
+/**
+ * Keyframes taken while merging into arr: the array as the trace shows it
+ * is arr before the merge position and rest from there on (arr itself for
+ * the top-down sort, the pass's source buffer for --natural).
+ */
+struct MergeFrames {
+    Keyframes& keyframes;
+    const vector<int>& rest;
+
+    void output(const vector<int>& arr, int k) const {
+        vector<int> shown(arr.begin(), arr.begin() + k);
+        shown.insert(shown.end(), rest.begin() + k, rest.end());
+        keyframes.begin();
+        keyframes.list("array", shown);
+        keyframes.end();
     }
+};
+
+static void mergeSpan(vector<int>& arr, const vector<int>& src, const MergeSpan& span, StepWriter& out,
+                      const MergeFrames* frames = nullptr) {
+    int i = span.i, j = span.j, k = span.k;
+    long long comparisons = 0;
     
-    int i = 0, j = 0, k = left;
-    
-    while (i < n1 && j < n2) {
+    while (i < span.iEnd || j < span.jEnd) {
         // Compare step
-        outputStep("compare", left + i, mid + 1 + j);
+        if (i <= span.mid && j <= span.right) {
+            outputStep(out, "compare", i, j);
+        }
+        comparisons += i < span.iEnd && j < span.jEnd;
         
-        if (L[i] <= R[j]) {
-            outputStep("overwrite", k, -1, L[i]);
-            arr[k] = L[i];
+        if (i < span.iEnd && (j == span.jEnd || src[i] <= src[j])) {
+            outputStep(out, "overwrite", k, -1, src[i]);
+            arr[k] = src[i];
             i++;
         } else {
-            outputStep("overwrite", k, -1, R[j]);
-            arr[k] = R[j];
+            outputStep(out, "overwrite", k, -1, src[j]);
+            arr[k] = src[j];
             j++;
         }
         k++;
+        if (frames && frames->keyframes.due()) {
+            frames->output(arr, k);
+        }
     }
-    
-    while (i < n1) {
-        outputStep("overwrite", k, -1, L[i]);
-        arr[k] = L[i];
-        i++;
-        k++;
-    }
-    
-    while (j < n2) {
-        outputStep("overwrite", k, -1, R[j]);
-        arr[k] = R[j];
-        j++;
-        k++;
-    }
+
+    // Spans of a parallel sort finish concurrently
+    OpCounters& ops = runMetrics().ops;
+    Metrics::countShared(ops.comparisons, comparisons);
+    Metrics::countShared(ops.overwrites, span.length());
 }
 
-void mergeSort(vector<int>& arr, int left, int right) {
+// Copy arr[left..right] to scratch and merge its sorted halves back
+static void merge(vector<int>& arr, vector<int>& scratch, int left, int mid, int right, StepWriter& out,
+                  const MergeFrames* frames) {
+    copy(arr.begin() + left, arr.begin() + right + 1, scratch.begin() + left);
+    MergeSpan span = {left, mid + 1, mid + 1, right + 1, left, mid, right};
+    mergeSpan(arr, scratch, span, out, frames);
+}
+
+static void mergeSort(vector<int>& arr, vector<int>& scratch, int left, int right, StepWriter& out,
+                      const MergeFrames* frames = nullptr) {
     if (left < right) {
         int mid = left + (right - left) / 2;
         
-        mergeSort(arr, left, mid);
-        mergeSort(arr, mid + 1, right);
+        mergeSort(arr, scratch, left, mid, out, frames);
+        mergeSort(arr, scratch, mid + 1, right, out, frames);
         
-        merge(arr, left, mid, right);
+        merge(arr, scratch, left, mid, right, out, frames);
     }
 }
 
-int main(int argc, char* argv[]) {
+/**
+ * Bottom-up natural merge sort: split the array into its maximal
+ * non-decreasing runs, then merge neighbouring runs pairwise, pass after
+ * pass, alternating between arr and scratch. No recursion and no
+ * allocation per merge; sorted input costs one scan, and input made of
+ * r runs needs ceil(log2 r) passes.
+ */
+static void naturalMergeSort(vector<int>& arr, vector<int>& scratch, StepWriter& out, Keyframes& keyframes) {
+    int n = arr.size();
+    vector<int> bounds(1, 0);   // Run r is [bounds[r], bounds[r + 1])
+    for (int i = 1; i < n; i++) {
+        outputStep(out, "compare", i - 1, i);
+        runMetrics().ops.comparisons++;
+        if (arr[i - 1] > arr[i]) {
+            bounds.push_back(i);
+        }
+        if (keyframes.due()) {
+            keyframes.begin();
+            keyframes.list("array", arr);
+            keyframes.end();
+        }
+    }
+    bounds.push_back(n);
+
+    vector<int>* src = &arr;
+    vector<int>* dst = &scratch;
+    while (bounds.size() > 2) {
+        size_t runs = bounds.size() - 1;
+        size_t kept = 0;
+        for (size_t r = 0; r < runs; r += 2) {
+            int left = bounds[r], mid = bounds[r + 1];
+            if (r + 1 < runs) {
+                int right = bounds[r + 2];
+                MergeSpan span = {left, mid, mid, right, left, mid - 1, right - 1};
+                MergeFrames frames = {keyframes, *src};
+                mergeSpan(*dst, *src, span, out, keyframes.enabled ? &frames : nullptr);
+            } else {
+                // An odd run out keeps its place; it only moves buffers
+                copy(src->begin() + left, src->begin() + mid, dst->begin() + left);
+            }
+            bounds[kept++] = left;
+        }
+        bounds[kept++] = n;
+        bounds.resize(kept);
+        swap(src, dst);
+    }
+
+    if (src != &arr) {
+        arr.swap(scratch);
+    }
+}
+
+/**
+ * Trace of one task: its own steps, followed by the traces of the tasks
+ * it split into, in the order the sequential sort would produce them.
+ */
+struct TracePiece {
+    StepWriter steps;
+    vector<unique_ptr<TracePiece>> parts;
+
+    TracePiece() : steps(0) {
+        steps.captureFor(stepWriter());
+    }
+
+    TracePiece* addPart() {
+        parts.push_back(unique_ptr<TracePiece>(new TracePiece()));
+        return parts.back().get();
+    }
+
+    void stitchInto(StepWriter& out) const {
+        out.appendSteps(steps);
+        for (const unique_ptr<TracePiece>& part : parts) {
+            part->stitchInto(out);
+        }
+    }
+};
+
+/**
+ * Merge sort on a work-stealing TaskScheduler. Both halves of a range
+ * are sorted as separate tasks and the merge runs as their continuation;
+ * a large merge is split at the median of its longer half (with a binary
+ * search in the other half) into two independent merges. Every task
+ * traces into its own TracePiece, so the stitched trace is the same as
+ * the sequential one regardless of scheduling.
+ */
+class ParallelMergeSort {
+public:
+    ParallelMergeSort(vector<int>& arr, vector<int>& scratch, TaskScheduler& scheduler)
+        : arr(arr), scratch(scratch), scheduler(scheduler) {}
+
+    void sort(TracePiece& trace) {
+        int right = (int)arr.size() - 1;
+        scheduler.run([this, right, &trace](int worker) {
+            sortRange(worker, 0, right, &trace, [](int) {});
+        });
+    }
+
+private:
+    vector<int>& arr;
+    vector<int>& scratch;
+    TaskScheduler& scheduler;
+
+    void sortRange(int worker, int left, int right, TracePiece* trace, Task done) {
+        if (right - left + 1 <= SORT_GRAIN) {
+            mergeSort(arr, scratch, left, right, trace->steps);
+            done(worker);
+            return;
+        }
+
+        int mid = left + (right - left) / 2;
+        TracePiece* lower = trace->addPart();
+        TracePiece* upper = trace->addPart();
+        TracePiece* merged = trace->addPart();
+        shared_ptr<JoinCounter> join = make_shared<JoinCounter>(2, [=](int w) {
+            copy(arr.begin() + left, arr.begin() + right + 1, scratch.begin() + left);
+            MergeSpan span = {left, mid + 1, mid + 1, right + 1, left, mid, right};
+            mergeRange(w, span, merged, done);
+        });
+        Task arrive = [join](int w) { join->arrive(w); };
+
+        scheduler.spawn(worker, [=](int w) { sortRange(w, mid + 1, right, upper, arrive); });
+        sortRange(worker, left, mid, lower, arrive);
+    }
+
+    void mergeRange(int worker, const MergeSpan& span, TracePiece* trace, Task done) {
+        if (span.length() <= MERGE_GRAIN) {
+            mergeSpan(arr, scratch, span, trace->steps);
+            done(worker);
+            return;
+        }
+
+        // Split so that first holds exactly the elements the merge emits
+        // before second: ties between the halves go to the left one
+        MergeSpan first = span, second = span;
+        if (span.iEnd - span.i >= span.jEnd - span.j) {
+            int p = span.i + (span.iEnd - span.i) / 2;
+            int q = (int)(lower_bound(scratch.begin() + span.j, scratch.begin() + span.jEnd, scratch[p]) - scratch.begin());
+            first.iEnd = second.i = p;
+            first.jEnd = second.j = q;
+        } else {
+            int q = span.j + (span.jEnd - span.j) / 2;
+            int p = (int)(upper_bound(scratch.begin() + span.i, scratch.begin() + span.iEnd, scratch[q]) - scratch.begin());
+            first.iEnd = second.i = p;
+            first.jEnd = second.j = q;
+        }
+        second.k = span.k + first.length();
+
+        TracePiece* lower = trace->addPart();
+        TracePiece* upper = trace->addPart();
+        shared_ptr<JoinCounter> join = make_shared<JoinCounter>(2, done);
+        Task arrive = [join](int w) { join->arrive(w); };
+
+        scheduler.spawn(worker, [=](int w) { mergeRange(w, second, upper, arrive); });
+        mergeRange(worker, first, lower, arrive);
+    }
+};
+
+int runMergeSort(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
     if (argc < 2) {
         cerr << "Usage: " << argv[0] << " <numbers>" << endl;
         return 1;
     }
 
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"compare"}, "i j value");
+    out.declareSteps({"overwrite"}, "i j value", TRACE_EVENTS);
+    out.declareSteps({"sorted"}, "i j value", TRACE_RESULT);
+    Keyframes keyframes(opts);
+
     vector<int> arr;
     
     for (int i = 1; i < argc; i++) {
@@ -93,16 +314,39 @@ int main(int argc, char* argv[]) {
     }
 
     int n = arr.size();
+    metrics.phase(PHASE_RUN);
     
     if (n > 0) {
-        mergeSort(arr, 0, n - 1);
+        vector<int> scratch(n);
+
+        if (opts.has("natural")) {
+            naturalMergeSort(arr, scratch, out, keyframes);
+        } else if (opts.has("parallel") && !out.hasBudget() && !keyframes.enabled && !out.paged()) {
+            WorkerPool pool(threadCount(opts));
+            TaskScheduler scheduler(pool);
+            TracePiece trace;
+            ParallelMergeSort(arr, scratch, scheduler).sort(trace);
+            trace.stitchInto(out);
+        } else {
+            MergeFrames frames = {keyframes, arr};
+            mergeSort(arr, scratch, 0, n - 1, out, keyframes.enabled ? &frames : nullptr);
+        }
         
         // Mark all elements as sorted
+        metrics.phase(PHASE_EMIT);
         for (int i = 0; i < n; i++) {
-            outputStep("sorted", i);
+            outputStep(out, "sorted", i);
         }
     }
 
+    finishMetrics();
+
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runMergeSort(argc, argv);
+}
+#endif
+
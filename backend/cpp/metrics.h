@@ -0,0 +1,222 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "options.h"
+#include "step_writer.h"
+
+/**
+ * Run Metrics
+ * With --metrics a program ends its trace with one metrics step (declared
+ * by startTrace) of 64-bit fields:
+ *   comparisons, swaps, overwrites     element operations of the sorts
+ *   relaxations                        edges examined (BFS, DFS) or relaxed
+ *                                      (Dijkstra, Bellman-Ford); (i, j, k)
+ *                                      checks in Floyd-Warshall
+ *   pushes, pops                       queue, stack or heap operations
+ *   stale_pops                         outdated heap entries Dijkstra skips
+ *   parse_ns, build_ns, run_ns,        wall time of each phase; emit covers
+ *   emit_ns                            the final results and flush
+ *   cycles, instructions,              hardware counters of the whole
+ *   cache_misses                       process in user space, from Linux
+ *                                      perf_event_open; left out when the
+ *                                      kernel does not allow them
+ *
+ * Usage:
+ *   Metrics& metrics = startMetrics(opts);   // right after parsing options
+ *   OpCounters& ops = runMetrics().ops;      // in the algorithm
+ *   ops.comparisons++;
+ *   metrics.phase(PHASE_RUN);                // at each phase boundary
+ *   finishMetrics();                         // instead of the final flush
+ *
+ * Counters are plain integers bumped on the hot path; parallel code sums
+ * per chunk and adds the totals with countShared.
+ */
+
+enum Phase {
+    PHASE_PARSE = 0,
+    PHASE_BUILD = 1,
+    PHASE_RUN = 2,
+    PHASE_EMIT = 3,
+    PHASE_COUNT = 4
+};
+
+struct OpCounters {
+    long long comparisons;
+    long long swaps;
+    long long overwrites;
+    long long relaxations;
+    long long pushes;
+    long long pops;
+    long long stalePops;
+};
+
+class Metrics {
+public:
+    OpCounters ops;
+
+    Metrics() : enabled(false), current(PHASE_PARSE) {
+        for (int c = 0; c < HW_COUNTERS; c++) {
+            counterFds[c] = -1;
+        }
+    }
+
+    ~Metrics() {
+        closeCounters();
+    }
+
+    /**
+     * Reset for a new run. Timing starts in the parse phase; hardware
+     * counters start only when --metrics is given.
+     */
+    void start(const Options& opts) {
+        memset(&ops, 0, sizeof(ops));
+        memset(phaseNanos, 0, sizeof(phaseNanos));
+        enabled = opts.has("metrics");
+        current = PHASE_PARSE;
+        phaseStart = Clock::now();
+        closeCounters();
+        if (enabled) {
+            openCounters();
+        }
+    }
+
+    void phase(Phase next) {
+        if (!enabled) return;
+        Clock::time_point now = Clock::now();
+        phaseNanos[current] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - phaseStart).count();
+        current = next;
+        phaseStart = now;
+    }
+
+    /**
+     * Flush the trace, then write the metrics step (when enabled) and end
+     * the trace with StepWriter::finishTrace.
+     */
+    void finish() {
+        StepWriter& out = stepWriter();
+        out.flush();
+        if (enabled) {
+            phase(PHASE_COUNT);     // Closes the emit phase
+            writeStep(out);
+            closeCounters();
+        }
+        out.finishTrace();
+    }
+
+    static void countShared(long long& counter, long long amount) {
+        __atomic_fetch_add(&counter, amount, __ATOMIC_RELAXED);
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    static const int HW_COUNTERS = 3;
+
+    bool enabled;
+    Phase current;
+    Clock::time_point phaseStart;
+    long long phaseNanos[PHASE_COUNT + 1];
+    int counterFds[HW_COUNTERS];
+
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+
+    void writeStep(StepWriter& out) {
+        out.beginStep("metrics");
+        out.field("comparisons", ops.comparisons);
+        out.field("swaps", ops.swaps);
+        out.field("overwrites", ops.overwrites);
+        out.field("relaxations", ops.relaxations);
+        out.field("pushes", ops.pushes);
+        out.field("pops", ops.pops);
+        out.field("stale_pops", ops.stalePops);
+        out.field("parse_ns", phaseNanos[PHASE_PARSE]);
+        out.field("build_ns", phaseNanos[PHASE_BUILD]);
+        out.field("run_ns", phaseNanos[PHASE_RUN]);
+        out.field("emit_ns", phaseNanos[PHASE_EMIT]);
+
+        long long values[HW_COUNTERS];
+        if (readCounters(values)) {
+            out.field("cycles", values[0]);
+            out.field("instructions", values[1]);
+            out.field("cache_misses", values[2]);
+        }
+        out.endStep();
+    }
+
+    void openCounters() {
+#ifdef __linux__
+        static const uint64_t configs[HW_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+        };
+        for (int c = 0; c < HW_COUNTERS; c++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[c];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = 1;       // Include worker threads started later
+            counterFds[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (counterFds[c] < 0) {
+                closeCounters();
+                return;
+            }
+        }
+#endif
+    }
+
+    bool readCounters(long long values[]) {
+#ifdef __linux__
+        for (int c = 0; c < HW_COUNTERS; c++) {
+            uint64_t value = 0;
+            if (counterFds[c] < 0 || read(counterFds[c], &value, sizeof(value)) != (ssize_t)sizeof(value)) {
+                return false;
+            }
+            values[c] = (long long)value;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void closeCounters() {
+        for (int c = 0; c < HW_COUNTERS; c++) {
+#ifdef __linux__
+            if (counterFds[c] >= 0) close(counterFds[c]);
+#endif
+            counterFds[c] = -1;
+        }
+    }
+};
+
+/**
+ * The metrics of the current run, shared like stepWriter().
+ */
+inline Metrics& runMetrics() {
+    static Metrics metrics;
+    return metrics;
+}
+
+inline Metrics& startMetrics(const Options& opts) {
+    Metrics& metrics = runMetrics();
+    metrics.start(opts);
+    return metrics;
+}
+
+inline void finishMetrics() {
+    runMetrics().finish();
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <map>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Command-Line Options
+ * Flags of the form --name or --name=value may appear anywhere on the
+ * command line. The constructor removes them from argv and updates argc,
+ * so the positional arguments keep the layout each program documents.
+ * Negative numbers ("-5") are positional, only "--" starts a flag.
+ */
+
+class Options {
+public:
+    Options(int& argc, char* argv[]) {
+        int kept = 1;
+        for (int i = 1; i < argc; i++) {
+            if (strncmp(argv[i], "--", 2) == 0 && argv[i][2] != '\0') {
+                const char* name = argv[i] + 2;
+                const char* equals = strchr(name, '=');
+                if (equals) {
+                    values[std::string(name, equals - name)] = equals + 1;
+                } else {
+                    values[name] = "";
+                }
+            } else {
+                argv[kept++] = argv[i];
+            }
+        }
+        argc = kept;
+        argv[argc] = nullptr;
+    }
+
+    bool has(const char* name) const {
+        return values.count(name) > 0;
+    }
+
+    std::string get(const char* name, const std::string& fallback = "") const {
+        std::map<std::string, std::string>::const_iterator it = values.find(name);
+        return it == values.end() ? fallback : it->second;
+    }
+
+    long long getInt(const char* name, long long fallback) const {
+        std::map<std::string, std::string>::const_iterator it = values.find(name);
+        if (it == values.end() || it->second.empty()) return fallback;
+        return atoll(it->second.c_str());
+    }
+
+private:
+    std::map<std::string, std::string> values;
+};
+
+#endif
+
@@ -0,0 +1,241 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+
+#include "options.h"
+
+/**
+ * Worker Pool
+ * A fixed set of threads for the data-parallel loops of the algorithms.
+ *   run(fn)                        calls fn(worker) once on every worker and
+ *                                  returns when all are done; the calling
+ *                                  thread is worker 0
+ *   parallelFor(count, grain, fn)  hands out [begin, end) ranges of at most
+ *                                  grain items to whichever worker is free,
+ *                                  calling fn(begin, end, worker)
+ * The threads live as long as the pool, so a loop that runs many short
+ * parallel phases pays for thread creation once. With a single thread
+ * everything runs inline on the caller.
+ */
+
+class WorkerPool {
+public:
+    explicit WorkerPool(int threadCount)
+        : workers(std::max(1, threadCount)), generation(0), running(0), stopping(false) {
+        for (int i = 1; i < workers; i++) {
+            threads.push_back(std::thread(&WorkerPool::workerLoop, this, i));
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    int size() const {
+        return workers;
+    }
+
+    template <typename Fn>
+    void run(Fn fn) {
+        if (workers == 1) {
+            fn(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = fn;
+            running = workers - 1;
+            generation++;
+        }
+        wake.notify_all();
+        fn(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return running == 0; });
+        task = nullptr;
+    }
+
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn fn) {
+        if (grain == 0) grain = 1;
+        if (workers == 1 || count <= grain) {
+            if (count > 0) fn((size_t)0, count, 0);
+            return;
+        }
+        std::atomic<size_t> next(0);
+        run([&](int worker) {
+            while (true) {
+                size_t begin = next.fetch_add(grain);
+                if (begin >= count) break;
+                fn(begin, std::min(begin + grain, count), worker);
+            }
+        });
+    }
+
+private:
+    int workers;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void(int)> task;
+    size_t generation;
+    int running;
+    bool stopping;
+
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+
+    void workerLoop(int index) {
+        size_t seen = 0;
+        while (true) {
+            std::function<void(int)> current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                current = task;
+            }
+            current(index);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+/**
+ * Work-Stealing Task Scheduler
+ * Runs a tree of tasks on a WorkerPool. Every worker owns a deque: it
+ * pushes and pops its own tasks at the back (depth first, so the data it
+ * just touched stays in cache) and, when that runs dry, steals from the
+ * front of another worker's deque, where the oldest and usually largest
+ * tasks sit.
+ *   run(root)              execute root(worker) and every task spawned from
+ *                          it; returns when all of them have finished
+ *   spawn(worker, task)    queue a task from inside a running task
+ * Tasks never block on each other; work that must follow several tasks
+ * goes in a JoinCounter that the last of them to finish runs.
+ */
+
+typedef std::function<void(int)> Task;
+
+class TaskScheduler {
+public:
+    explicit TaskScheduler(WorkerPool& pool) : pool(pool), queues(pool.size()), pending(0) {}
+
+    void run(const Task& root) {
+        spawn(0, root);
+        pool.run([this](int worker) { workLoop(worker); });
+    }
+
+    void spawn(int worker, const Task& task) {
+        pending.fetch_add(1);
+        WorkQueue& queue = queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    WorkerPool& pool;
+    std::vector<WorkQueue> queues;
+    std::atomic<long> pending;      // Spawned tasks that have not finished
+
+    TaskScheduler(const TaskScheduler&);
+    TaskScheduler& operator=(const TaskScheduler&);
+
+    bool take(int worker, Task& task) {
+        {
+            WorkQueue& own = queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        int count = (int)queues.size();
+        for (int offset = 1; offset < count; offset++) {
+            WorkQueue& victim = queues[(worker + offset) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workLoop(int worker) {
+        Task task;
+        // A running task spawns its children before it counts as finished,
+        // so pending only reaches zero once the whole tree is done
+        while (pending.load() > 0) {
+            if (take(worker, task)) {
+                task(worker);
+                task = nullptr;
+                pending.fetch_sub(1);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+/**
+ * Runs a continuation on the worker of whichever of count tasks calls
+ * arrive() last.
+ */
+class JoinCounter {
+public:
+    JoinCounter(int count, const Task& continuation) : remaining(count), continuation(continuation) {}
+
+    void arrive(int worker) {
+        if (remaining.fetch_sub(1) == 1) {
+            continuation(worker);
+        }
+    }
+
+private:
+    std::atomic<int> remaining;
+    Task continuation;
+};
+
+/**
+ * Number of worker threads requested with --threads=<n>; defaults to the
+ * number of hardware threads.
+ */
+inline int threadCount(const Options& opts) {
+    long long threads = opts.getInt("threads", 0);
+    if (threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return (int)std::max(1LL, std::min(threads, 256LL));
+}
+
+#endif
+
@@ -0,0 +1,443 @@
+#include <iostream>
+#include <vector>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+
+#include "algorithms.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "step_writer.h"
+
+using namespace std;
+
+/**
+ * Pattern-Defeating Quicksort (pdqsort)
+ * Outputs JSON steps for visualization:
+ * - compare(i, j): Comparing elements at indices i and j
+ * - swap(i, j): Swapping elements at indices i and j
+ * - overwrite(i, value): Insertion sort shifting or placing an element
+ * - sorted(i): Element at index i is in final sorted position
+ *
+ * Introsort in the style of Orson Peters' pdqsort: ranges under
+ * INSERTION_THRESHOLD are insertion sorted, pivots are a median of 3 (a
+ * pseudo-median of 9 above NINTHER_THRESHOLD) moved to the front of the
+ * range, and partitioning is branchless: a block of elements is scanned
+ * into a buffer of offsets of the misplaced ones, and the two blocks'
+ * offsets are then swapped pairwise, so the scan has no data-dependent
+ * branches to mispredict. Patterns are defeated three ways:
+ *   - runs of equal elements: when the pivot equals the element left of
+ *     the range, everything equal to it is put left and skipped
+ *   - sorted input: a partition that swapped nothing is followed by an
+ *     insertion sort that gives up after PARTIAL_INSERTION_LIMIT moves
+ *   - bad pivots: an unbalanced partition shuffles a few elements of
+ *     each side, and after log2(n) of them the range is heapsorted
+ * The pivot stays at the front of its range while partitioning, so every
+ * compare step against it names a real index.
+ */
+
+static const int INSERTION_THRESHOLD = 24;
+static const int NINTHER_THRESHOLD = 128;
+static const int PARTIAL_INSERTION_LIMIT = 8;
+static const int BLOCK_SIZE = 64;
+
+// The value goes with hasValue rather than a sentinel: any int is a valid key
+static void outputStep(StepWriter& out, const char* type, int i, int j = -1, bool hasValue = false, int value = 0) {
+    out.beginStep(type);
+    out.field("i", i);
+    if (j != -1) {
+        out.field("j", j);
+    }
+    if (hasValue) {
+        out.field("value", value);
+    }
+    out.endStep();
+}
+
+class PdqSort {
+public:
+    PdqSort(vector<int>& arr, StepWriter& out, Keyframes& keyframes)
+        : arr(arr), out(out), ops(runMetrics().ops), keyframes(keyframes) {}
+
+    void sort() {
+        int n = arr.size();
+        if (n < 2) return;
+        int badAllowed = 0;
+        for (int size = n; size > 1; size >>= 1) {
+            badAllowed++;
+        }
+        sortRange(0, n, badAllowed, true);
+    }
+
+private:
+    vector<int>& arr;
+    StepWriter& out;
+    OpCounters& ops;
+    Keyframes& keyframes;
+
+    // arr[i] < arr[j]
+    bool less(int i, int j) {
+        if (out.emits(TRACE_FULL)) {
+            outputStep(out, "compare", i, j);
+        }
+        ops.comparisons++;
+        keyframe();
+        return arr[i] < arr[j];
+    }
+
+    void swapAt(int i, int j) {
+        outputStep(out, "swap", i, j);
+        swap(arr[i], arr[j]);
+        ops.swaps++;
+        keyframe();
+    }
+
+    void overwrite(int i, int value) {
+        if (out.emits(TRACE_EVENTS)) {
+            outputStep(out, "overwrite", i, -1, true, value);
+        }
+        arr[i] = value;
+        ops.overwrites++;
+        keyframe();
+    }
+
+    void keyframe() {
+        if (keyframes.due()) {
+            keyframes.begin();
+            keyframes.list("array", arr);
+            keyframes.end();
+        }
+    }
+
+    /**
+     * Insert arr[i] into the sorted elements before it, traced like
+     * insertion.cpp; returns how far it moved. Unguarded insertion needs
+     * an element no greater than any in the range just left of `lo`.
+     */
+    int insert(int lo, int i, bool guarded) {
+        int key = arr[i];
+        int j = i - 1;
+        while (!guarded || j >= lo) {
+            if (out.emits(TRACE_FULL)) {
+                outputStep(out, "compare", j, i);
+            }
+            ops.comparisons++;
+            keyframe();
+            if (arr[j] <= key) break;
+            overwrite(j + 1, arr[j]);
+            j--;
+        }
+        if (j + 1 != i) {
+            overwrite(j + 1, key);
+        }
+        return i - (j + 1);
+    }
+
+    void insertionSort(int begin, int end, bool leftmost) {
+        for (int i = begin + 1; i < end; i++) {
+            insert(begin, i, leftmost);
+        }
+    }
+
+    // Insertion sort that gives up once too many elements moved
+    bool partialInsertionSort(int begin, int end) {
+        int moved = 0;
+        for (int i = begin + 1; i < end; i++) {
+            moved += insert(begin, i, true);
+            if (moved > PARTIAL_INSERTION_LIMIT) return false;
+        }
+        return true;
+    }
+
+    void sort2(int a, int b) {
+        if (less(b, a)) swapAt(a, b);
+    }
+
+    void sort3(int a, int b, int c) {
+        sort2(a, b);
+        sort2(b, c);
+        sort2(a, b);
+    }
+
+    // Move the median of 3 (or pseudo-median of 9) to arr[begin]
+    void choosePivot(int begin, int end) {
+        int size = end - begin;
+        int half = size / 2;
+        if (size > NINTHER_THRESHOLD) {
+            sort3(begin, begin + half, end - 1);
+            sort3(begin + 1, begin + half - 1, end - 2);
+            sort3(begin + 2, begin + half + 1, end - 3);
+            sort3(begin + half - 1, begin + half, begin + half + 1);
+            swapAt(begin, begin + half);
+        } else {
+            sort3(begin + half, begin, end - 1);
+        }
+    }
+
+    // Trace the compares of a block scan against the pivot at `pivot`
+    void traceBlock(int from, int count, int step, int pivot) {
+        ops.comparisons += count;
+        if (!out.emits(TRACE_FULL)) return;
+        for (int i = 0; i < count; i++) {
+            outputStep(out, "compare", from + i * step, pivot);
+        }
+        keyframe();
+    }
+
+    /**
+     * Partition [begin, end) around the pivot at arr[begin]: smaller
+     * elements left, the rest right. Returns the pivot's final position
+     * and whether the range was already partitioned (no swaps needed).
+     */
+    pair<int, bool> partitionRight(int begin, int end) {
+        int pivot = arr[begin];
+        int first = begin, last = end;
+
+        // The median of 3 left an element >= pivot at the end, and an
+        // element < pivot found here stops the scan from the right
+        while (less(++first, begin)) {}
+        if (first - 1 == begin) {
+            while (first < last && !less(--last, begin)) {}
+        } else {
+            while (!less(--last, begin)) {}
+        }
+
+        bool alreadyPartitioned = first >= last;
+        if (!alreadyPartitioned) {
+            swapAt(first, last);
+            first++;
+
+            // Offsets of elements on the wrong side, from the start of the
+            // left block and the end of the right block
+            unsigned char offsetsLeft[BLOCK_SIZE], offsetsRight[BLOCK_SIZE];
+            int baseLeft = first, baseRight = last;
+            int numLeft = 0, numRight = 0, startLeft = 0, startRight = 0;
+
+            while (first < last) {
+                // Scan only the side(s) whose buffer is empty; the last
+                // blocks share what is left
+                int unknown = last - first;
+                int leftSplit = numLeft == 0 ? (numRight == 0 ? unknown / 2 : unknown) : 0;
+                int rightSplit = numRight == 0 ? unknown - leftSplit : 0;
+                leftSplit = min(leftSplit, BLOCK_SIZE);
+                rightSplit = min(rightSplit, BLOCK_SIZE);
+
+                traceBlock(first, leftSplit, 1, begin);
+                for (int i = 0; i < leftSplit; i++) {
+                    offsetsLeft[numLeft] = (unsigned char)i;
+                    numLeft += !(arr[first + i] < pivot);
+                }
+                first += leftSplit;
+
+                traceBlock(last - 1, rightSplit, -1, begin);
+                for (int i = 1; i <= rightSplit; i++) {
+                    offsetsRight[numRight] = (unsigned char)i;
+                    numRight += arr[last - i] < pivot;
+                }
+                last -= rightSplit;
+
+                int num = min(numLeft, numRight);
+                for (int i = 0; i < num; i++) {
+                    swapAt(baseLeft + offsetsLeft[startLeft + i], baseRight - offsetsRight[startRight + i]);
+                }
+                numLeft -= num;
+                numRight -= num;
+                startLeft += num;
+                startRight += num;
+
+                if (numLeft == 0) {
+                    startLeft = 0;
+                    baseLeft = first;
+                }
+                if (numRight == 0) {
+                    startRight = 0;
+                    baseRight = last;
+                }
+            }
+
+            // Everything is scanned; move the leftovers of one buffer
+            // across the boundary
+            if (numLeft > 0) {
+                while (numLeft > 0) {
+                    numLeft--;
+                    int from = baseLeft + offsetsLeft[startLeft + numLeft];
+                    if (from != --last) swapAt(from, last);
+                }
+                first = last;
+            }
+            if (numRight > 0) {
+                while (numRight > 0) {
+                    numRight--;
+                    int from = baseRight - offsetsRight[startRight + numRight];
+                    if (from != first) swapAt(from, first);
+                    first++;
+                }
+                last = first;
+            }
+        }
+
+        int pivotPos = first - 1;
+        if (pivotPos != begin) {
+            swapAt(begin, pivotPos);
+        }
+        return make_pair(pivotPos, alreadyPartitioned);
+    }
+
+    /**
+     * Partition [begin, end) around the pivot at arr[begin] with elements
+     * equal to it going left. Used when the pivot equals the element just
+     * left of the range, so the left side is all equal and already done.
+     */
+    int partitionLeft(int begin, int end) {
+        int first = begin, last = end;
+        while (less(begin, --last)) {}
+        if (last + 1 == end) {
+            while (first < last && !less(begin, ++first)) {}
+        } else {
+            while (!less(begin, ++first)) {}
+        }
+
+        while (first < last) {
+            swapAt(first, last);
+            while (less(begin, --last)) {}
+            while (!less(begin, ++first)) {}
+        }
+
+        if (last != begin) {
+            swapAt(begin, last);
+        }
+        return last;
+    }
+
+    void siftDown(int begin, int root, int size) {
+        while (2 * root + 1 < size) {
+            int child = 2 * root + 1;
+            if (child + 1 < size && less(begin + child, begin + child + 1)) {
+                child++;
+            }
+            if (!less(begin + root, begin + child)) return;
+            swapAt(begin + root, begin + child);
+            root = child;
+        }
+    }
+
+    void heapSort(int begin, int end) {
+        int size = end - begin;
+        for (int root = size / 2 - 1; root >= 0; root--) {
+            siftDown(begin, root, size);
+        }
+        for (int last = size - 1; last > 0; last--) {
+            swapAt(begin, begin + last);
+            siftDown(begin, 0, last);
+        }
+    }
+
+    // Swap a few elements of an unbalanced side to break its pattern
+    void breakPatterns(int begin, int end, int pivotPos) {
+        int leftSize = pivotPos - begin;
+        int rightSize = end - (pivotPos + 1);
+
+        if (leftSize >= INSERTION_THRESHOLD) {
+            swapAt(begin, begin + leftSize / 4);
+            swapAt(pivotPos - 1, pivotPos - leftSize / 4);
+            if (leftSize > NINTHER_THRESHOLD) {
+                swapAt(begin + 1, begin + (leftSize / 4 + 1));
+                swapAt(begin + 2, begin + (leftSize / 4 + 2));
+                swapAt(pivotPos - 2, pivotPos - (leftSize / 4 + 1));
+                swapAt(pivotPos - 3, pivotPos - (leftSize / 4 + 2));
+            }
+        }
+        if (rightSize >= INSERTION_THRESHOLD) {
+            swapAt(pivotPos + 1, pivotPos + (1 + rightSize / 4));
+            swapAt(end - 1, end - rightSize / 4);
+            if (rightSize > NINTHER_THRESHOLD) {
+                swapAt(pivotPos + 2, pivotPos + (2 + rightSize / 4));
+                swapAt(pivotPos + 3, pivotPos + (3 + rightSize / 4));
+                swapAt(end - 2, end - (1 + rightSize / 4));
+                swapAt(end - 3, end - (2 + rightSize / 4));
+            }
+        }
+    }
+
+    // Sort [begin, end); recurses on the left side and loops on the right
+    void sortRange(int begin, int end, int badAllowed, bool leftmost) {
+        while (true) {
+            int size = end - begin;
+            if (size < INSERTION_THRESHOLD) {
+                insertionSort(begin, end, leftmost);
+                return;
+            }
+
+            choosePivot(begin, end);
+
+            if (!leftmost && !less(begin - 1, begin)) {
+                begin = partitionLeft(begin, end) + 1;
+                continue;
+            }
+
+            pair<int, bool> split = partitionRight(begin, end);
+            int pivotPos = split.first;
+            int leftSize = pivotPos - begin;
+            int rightSize = end - (pivotPos + 1);
+
+            if (leftSize < size / 8 || rightSize < size / 8) {
+                if (--badAllowed == 0) {
+                    heapSort(begin, end);
+                    return;
+                }
+                breakPatterns(begin, end, pivotPos);
+            } else if (split.second && partialInsertionSort(begin, pivotPos) &&
+                       partialInsertionSort(pivotPos + 1, end)) {
+                return;
+            }
+
+            sortRange(begin, pivotPos, badAllowed, leftmost);
+            begin = pivotPos + 1;
+            leftmost = false;
+        }
+    }
+};
+
+int runPdqSort(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <numbers>" << endl;
+        return 1;
+    }
+
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"compare"}, "i j value");
+    out.declareSteps({"swap", "overwrite"}, "i j value", TRACE_EVENTS);
+    out.declareSteps({"sorted"}, "i j value", TRACE_RESULT);
+    Keyframes keyframes(opts);
+
+    vector<int> arr;
+
+    for (int i = 1; i < argc; i++) {
+        arr.push_back(atoi(argv[i]));
+    }
+
+    int n = arr.size();
+    metrics.phase(PHASE_RUN);
+
+    PdqSort(arr, out, keyframes).sort();
+
+    // Mark all elements as sorted
+    metrics.phase(PHASE_EMIT);
+    for (int i = 0; i < n; i++) {
+        outputStep(out, "sorted", i);
+    }
+
+    finishMetrics();
+
+    return 0;
+}
+
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runPdqSort(argc, argv);
+}
+#endif
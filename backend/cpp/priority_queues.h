@@ -0,0 +1,226 @@
+#ifndef PRIORITY_QUEUES_H
+#define PRIORITY_QUEUES_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cstdint>
+
+/**
+ * Priority Queues for Dijkstra
+ * Each queue holds (distance, node) entries and pops the smallest
+ * distance first. They share one interface:
+ *   push(node, dist)       insert node, or lower the distance of a queued node
+ *   empty(), size()
+ *   popMin(node, dist)     remove the smallest entry
+ *   entries(out)           all entries as (dist, node) pairs in pop order
+ *
+ * LazyBinaryHeap   binary heap with lazy deletion: a lowered distance is a
+ *                  new entry and the old one is left to be skipped when it
+ *                  is popped. Holds O(E) entries. Ties pop by node.
+ * IndexedDaryHeap  D-ary heap with a node -> slot index, so a lowered
+ *                  distance is a real decrease-key. Holds at most one
+ *                  entry per node, O(V). Ties pop by node.
+ * RadixHeap        monotone heap for non-negative integer distances
+ *                  (which Dijkstra pops in non-decreasing order): entries
+ *                  are bucketed by the highest bit where they differ from
+ *                  the last popped distance. O(1) push, amortized O(log C)
+ *                  pop; lazy like the binary heap. Ties pop in any order.
+ */
+
+class LazyBinaryHeap {
+public:
+    explicit LazyBinaryHeap(int = 0) {}
+
+    void push(int node, int dist) {
+        heap.push_back(std::make_pair(dist, node));
+        std::push_heap(heap.begin(), heap.end(), Greater());
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    size_t size() const {
+        return heap.size();
+    }
+
+    void popMin(int& node, int& dist) {
+        std::pop_heap(heap.begin(), heap.end(), Greater());
+        dist = heap.back().first;
+        node = heap.back().second;
+        heap.pop_back();
+    }
+
+    void entries(std::vector<std::pair<int, int>>& out) const {
+        out.assign(heap.begin(), heap.end());
+        std::sort(out.begin(), out.end());
+    }
+
+private:
+    typedef std::greater<std::pair<int, int>> Greater;
+    std::vector<std::pair<int, int>> heap;
+};
+
+template <int D>
+class IndexedDaryHeap {
+public:
+    explicit IndexedDaryHeap(int numNodes) : slot(numNodes, -1), key(numNodes, 0) {
+        heap.reserve(numNodes);
+    }
+
+    void push(int node, int dist) {
+        if (slot[node] == -1) {
+            key[node] = dist;
+            slot[node] = (int)heap.size();
+            heap.push_back(node);
+            siftUp(slot[node]);
+        } else if (dist < key[node]) {
+            key[node] = dist;
+            siftUp(slot[node]);
+        }
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    size_t size() const {
+        return heap.size();
+    }
+
+    void popMin(int& node, int& dist) {
+        node = heap[0];
+        dist = key[node];
+        slot[node] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            slot[last] = 0;
+            siftDown(0);
+        }
+    }
+
+    void entries(std::vector<std::pair<int, int>>& out) const {
+        out.clear();
+        for (int node : heap) {
+            out.push_back(std::make_pair(key[node], node));
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+private:
+    std::vector<int> heap;      // Nodes in heap order
+    std::vector<int> slot;      // Index of each node in heap, -1 if absent
+    std::vector<int> key;       // Queued distance of each node
+
+    bool before(int a, int b) const {
+        return key[a] < key[b] || (key[a] == key[b] && a < b);
+    }
+
+    void place(int node, int index) {
+        heap[index] = node;
+        slot[node] = index;
+    }
+
+    void siftUp(int index) {
+        int node = heap[index];
+        while (index > 0) {
+            int parent = (index - 1) / D;
+            if (!before(node, heap[parent])) break;
+            place(heap[parent], index);
+            index = parent;
+        }
+        place(node, index);
+    }
+
+    void siftDown(int index) {
+        int node = heap[index];
+        int size = (int)heap.size();
+        while (true) {
+            int first = index * D + 1;
+            if (first >= size) break;
+            int best = first;
+            int last = std::min(first + D, size);
+            for (int child = first + 1; child < last; child++) {
+                if (before(heap[child], heap[best])) best = child;
+            }
+            if (!before(heap[best], node)) break;
+            place(heap[best], index);
+            index = best;
+        }
+        place(node, index);
+    }
+};
+
+class RadixHeap {
+public:
+    explicit RadixHeap(int = 0) : last(0), count(0) {}
+
+    // dist must not be below the last popped distance
+    void push(int node, int dist) {
+        buckets[bucketOf((uint32_t)dist)].push_back(std::make_pair((uint32_t)dist, node));
+        count++;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    void popMin(int& node, int& dist) {
+        if (buckets[0].empty()) {
+            int b = 1;
+            while (buckets[b].empty()) b++;
+
+            // The bucket's minimum becomes the new reference point; every
+            // entry of the bucket then moves to a lower one
+            std::vector<Entry>& source = buckets[b];
+            uint32_t smallest = source[0].first;
+            for (const Entry& entry : source) {
+                smallest = std::min(smallest, entry.first);
+            }
+            last = smallest;
+            for (const Entry& entry : source) {
+                buckets[bucketOf(entry.first)].push_back(entry);
+            }
+            source.clear();
+        }
+
+        dist = (int)buckets[0].back().first;
+        node = buckets[0].back().second;
+        buckets[0].pop_back();
+        count--;
+    }
+
+    void entries(std::vector<std::pair<int, int>>& out) const {
+        out.clear();
+        for (int b = 0; b < BUCKETS; b++) {
+            for (const Entry& entry : buckets[b]) {
+                out.push_back(std::make_pair((int)entry.first, entry.second));
+            }
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+private:
+    typedef std::pair<uint32_t, int> Entry;
+    static const int BUCKETS = 33;
+
+    std::vector<Entry> buckets[BUCKETS];
+    uint32_t last;
+    size_t count;
+
+    // 0 for the last popped distance, else 1 + index of the highest differing bit
+    int bucketOf(uint32_t dist) const {
+        return dist == last ? 0 : 32 - __builtin_clz(dist ^ last);
+    }
+};
+
+#endif
+
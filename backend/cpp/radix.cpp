@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+#include <sstream>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#include "algorithms.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "step_writer.h"
+
+using namespace std;
+
+/**
+ * LSD Radix Sort
+ * Outputs JSON steps for visualization:
+ * - overwrite(i, value): A pass writing value to index i
+ * - sorted(i): Element at index i is in final sorted position
+ *
+ * Sorts the int32 keys RADIX_BITS at a time, least significant digit
+ * first, with the sign bit flipped so negative keys come first. One read
+ * of the input counts the histograms of every pass; a pass whose digit is
+ * the same for all keys is skipped. Each pass scatters stably from one
+ * buffer into the other, so the only allocation is one scratch buffer,
+ * and the result is moved back if it ended there.
+ * Every pass writes each index exactly once, so the trace shows one
+ * array, the one being written. Radix sort never compares keys; its
+ * --keyframes are written between passes.
+ */
+
+static const int RADIX_BITS = 8;
+static const int BUCKETS = 1 << RADIX_BITS;
+static const int PASSES = 32 / RADIX_BITS;
+
+// The value goes with hasValue rather than a sentinel: any int is a valid key
+static void outputStep(StepWriter& out, const char* type, int i, int j = -1, bool hasValue = false, int value = 0) {
+    out.beginStep(type);
+    out.field("i", i);
+    if (j != -1) {
+        out.field("j", j);
+    }
+    if (hasValue) {
+        out.field("value", value);
+    }
+    out.endStep();
+}
+
+// Order-preserving unsigned form of a key
+static inline uint32_t radixKey(int value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+static void radixSort(vector<int>& arr, StepWriter& out, Keyframes& keyframes) {
+    int n = arr.size();
+    if (n == 0) return;
+
+    vector<int> counts(PASSES * BUCKETS, 0);
+    for (int value : arr) {
+        uint32_t key = radixKey(value);
+        for (int pass = 0; pass < PASSES; pass++) {
+            counts[pass * BUCKETS + ((key >> (pass * RADIX_BITS)) & (BUCKETS - 1))]++;
+        }
+    }
+
+    vector<int> scratch(n);
+    vector<int>* src = &arr;
+    vector<int>* dst = &scratch;
+    bool traced = out.emits(TRACE_EVENTS);
+    OpCounters& ops = runMetrics().ops;
+
+    for (int pass = 0; pass < PASSES; pass++) {
+        int shift = pass * RADIX_BITS;
+        int* next = &counts[pass * BUCKETS];
+        if (next[(radixKey((*src)[0]) >> shift) & (BUCKETS - 1)] == n) {
+            continue;
+        }
+
+        // Turn the histogram into each bucket's first index
+        int start = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            int count = next[b];
+            next[b] = start;
+            start += count;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int value = (*src)[i];
+            int k = next[(radixKey(value) >> shift) & (BUCKETS - 1)]++;
+            (*dst)[k] = value;
+            if (traced) {
+                outputStep(out, "overwrite", k, -1, true, value);
+            }
+        }
+        ops.overwrites += n;
+        swap(src, dst);
+
+        if (keyframes.due()) {
+            keyframes.begin();
+            keyframes.list("array", *src);
+            keyframes.end();
+        }
+    }
+
+    if (src != &arr) {
+        arr.swap(scratch);
+    }
+}
+
+int runRadixSort(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <numbers>" << endl;
+        return 1;
+    }
+
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"overwrite"}, "i j value", TRACE_EVENTS);
+    out.declareSteps({"sorted"}, "i j value", TRACE_RESULT);
+    Keyframes keyframes(opts);
+
+    vector<int> arr;
+
+    for (int i = 1; i < argc; i++) {
+        arr.push_back(atoi(argv[i]));
+    }
+
+    int n = arr.size();
+    metrics.phase(PHASE_RUN);
+
+    radixSort(arr, out, keyframes);
+
+    // Mark all elements as sorted
+    metrics.phase(PHASE_EMIT);
+    for (int i = 0; i < n; i++) {
+        outputStep(out, "sorted", i);
+    }
+
+    finishMetrics();
+
+    return 0;
+}
+
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runRadixSort(argc, argv);
+}
+#endif
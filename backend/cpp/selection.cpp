@@ -4,32 +4,62 @@
 #include <cstdlib>
 #include <algorithm>
 
+#include "algorithms.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "options.h"
+#include "simd_argmin.h"
+#include "step_writer.h"
+
 using namespace std;
 
 /**
  * Selection Sort Algorithm
  * Outputs JSON steps for visualization
+ * When the trace level drops compare steps, each scan for the minimum is
+ * one call of a SIMD argmin kernel (see simd_argmin.h) and only the swap
+ * and sorted steps are written; the trace is the same as the scalar
+ * scan's. --simd=<avx2|sse4.1|scalar> forces a kernel (default: the
+ * best this CPU supports).
  */
 
-void outputStep(const string& type, int i, int j = -1, int value = -1) {
-    cout << "{";
-    cout << "\"type\":\"" << type << "\"";
-    cout << ",\"i\":" << i;
+static void outputStep(const char* type, int i, int j = -1, int value = -1) {
+    StepWriter& out = stepWriter();
+    out.beginStep(type);
+    out.field("i", i);
     if (j != -1) {
-        cout << ",\"j\":" << j;
+        out.field("j", j);
     }
     if (value != -1) {
-        cout << ",\"value\":" << value;
+        out.field("value", value);
     }
-    cout << "}" << endl;
+    out.endStep();
 }
 
-int main(int argc, char* argv[]) {
+int runSelectionSort(int argc, char* argv[]) {
+    Options opts(argc, argv);
+    Metrics& metrics = startMetrics(opts);
+
     if (argc < 2) {
         cerr << "Usage: " << argv[0] << " <numbers>" << endl;
         return 1;
     }
 
+    ArgminKernel argmin = bestArgminKernel();
+    if (opts.has("simd")) {
+        argmin = findArgminKernel(opts.get("simd"));
+        if (!argmin) {
+            cerr << "Unsupported --simd kernel '" << opts.get("simd") << "', use avx2, sse4.1 or scalar" << endl;
+            return 1;
+        }
+    }
+
+    StepWriter& out = startTrace(opts);
+    out.declareSteps({"compare"}, "i j value");
+    out.declareSteps({"swap"}, "i j value", TRACE_EVENTS);
+    out.declareSteps({"sorted"}, "i j value", TRACE_RESULT);
+    Keyframes keyframes(opts);
+
     vector<int> arr;
     
     for (int i = 1; i < argc; i++) {
@@ -37,25 +67,48 @@ int main(int argc, char* argv[]) {
     }
 
     int n = arr.size();
+    OpCounters& ops = metrics.ops;
+    metrics.phase(PHASE_RUN);
     
     // Selection Sort
     for (int i = 0; i < n - 1; i++) {
         int minIdx = i;
         
-        // Find minimum element in unsorted portion
-        for (int j = i + 1; j < n; j++) {
-            // Compare step
-            outputStep("compare", minIdx, j);
-            
-            if (arr[j] < arr[minIdx]) {
-                minIdx = j;
+        if (out.emits(TRACE_FULL)) {
+            // Find minimum element in unsorted portion
+            for (int j = i + 1; j < n; j++) {
+                // Compare step (a step budget can lower the level mid-scan)
+                if (out.emits(TRACE_FULL)) {
+                    outputStep("compare", minIdx, j);
+                }
+                ops.comparisons++;
+                
+                if (arr[j] < arr[minIdx]) {
+                    minIdx = j;
+                }
+                if (keyframes.due()) {
+                    keyframes.begin();
+                    keyframes.list("array", arr);
+                    keyframes.end();
+                }
+            }
+        } else {
+            // No steps are written during the scan, so a keyframe due in
+            // it is due before it
+            if (keyframes.due()) {
+                keyframes.begin();
+                keyframes.list("array", arr);
+                keyframes.end();
             }
+            minIdx = i + argmin(arr.data() + i, n - i);
+            ops.comparisons += n - 1 - i;
         }
         
         // Swap if minimum is not at current position
         if (minIdx != i) {
             outputStep("swap", i, minIdx);
             swap(arr[i], arr[minIdx]);
+            ops.swaps++;
         }
         
         // Mark current position as sorted
@@ -67,6 +120,15 @@ int main(int argc, char* argv[]) {
         outputStep("sorted", n - 1);
     }
 
+    metrics.phase(PHASE_EMIT);
+    finishMetrics();
+
     return 0;
 }
 
+#ifndef ALGO_ENGINE
+int main(int argc, char* argv[]) {
+    return runSelectionSort(argc, argv);
+}
+#endif
+
@@ -0,0 +1,131 @@
+#ifndef SIMD_ARGMIN_H
+#define SIMD_ARGMIN_H
+
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ARGMIN_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * SIMD Argmin
+ * Kernels of type ArgminKernel return the index of the first smallest of
+ * data[0..n) (n > 0), the element a scalar
+ * `if (data[j] < data[best]) best = j` scan picks.
+ *
+ * Kernels: avx2 (8 lanes), sse4.1 (4 lanes) and scalar. Every lane keeps
+ * its running minimum and the index it was first seen at, updated with a
+ * compare and two blends, so the scan has no branches; the lanes are
+ * reduced at the end with ties going to the lower index.
+ * bestArgminKernel is the best one the CPU supports, picked at runtime on
+ * x86 builds with GCC or Clang (scalar elsewhere); findArgminKernel picks
+ * one by name.
+ *
+ * The other quadratic sorts' scans fit the same shape: per-lane best
+ * values and indices, one reduction after the loop.
+ */
+
+typedef int (*ArgminKernel)(const int* data, int n);
+
+inline int argminScalar(const int* data, int n) {
+    int best = 0;
+    for (int j = 1; j < n; j++) {
+        if (data[j] < data[best]) {
+            best = j;
+        }
+    }
+    return best;
+}
+
+#ifdef ARGMIN_X86
+// Reduce the lanes' (value, index) pairs, then scan the tail from `next`
+inline int finishArgmin(const int* data, int n, int next, const int* values, const int* indices, int lanes) {
+    int best = indices[0];
+    for (int lane = 1; lane < lanes; lane++) {
+        if (values[lane] < data[best] || (values[lane] == data[best] && indices[lane] < best)) {
+            best = indices[lane];
+        }
+    }
+    for (int j = next; j < n; j++) {
+        if (data[j] < data[best]) {
+            best = j;
+        }
+    }
+    return best;
+}
+
+__attribute__((target("sse4.1")))
+inline int argminSse41(const int* data, int n) {
+    if (n < 8) return argminScalar(data, n);
+
+    __m128i bestValues = _mm_loadu_si128((const __m128i*)data);
+    __m128i bestIndices = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i indices = bestIndices;
+    const __m128i step = _mm_set1_epi32(4);
+    int j = 4;
+    for (; j + 4 <= n; j += 4) {
+        indices = _mm_add_epi32(indices, step);
+        __m128i values = _mm_loadu_si128((const __m128i*)(data + j));
+        __m128i smaller = _mm_cmplt_epi32(values, bestValues);
+        bestValues = _mm_blendv_epi8(bestValues, values, smaller);
+        bestIndices = _mm_blendv_epi8(bestIndices, indices, smaller);
+    }
+
+    int values[4], lanes[4];
+    _mm_storeu_si128((__m128i*)values, bestValues);
+    _mm_storeu_si128((__m128i*)lanes, bestIndices);
+    return finishArgmin(data, n, j, values, lanes, 4);
+}
+
+__attribute__((target("avx2")))
+inline int argminAvx2(const int* data, int n) {
+    if (n < 16) return argminScalar(data, n);
+
+    __m256i bestValues = _mm256_loadu_si256((const __m256i*)data);
+    __m256i bestIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i indices = bestIndices;
+    const __m256i step = _mm256_set1_epi32(8);
+    int j = 8;
+    for (; j + 8 <= n; j += 8) {
+        indices = _mm256_add_epi32(indices, step);
+        __m256i values = _mm256_loadu_si256((const __m256i*)(data + j));
+        __m256i smaller = _mm256_cmpgt_epi32(bestValues, values);
+        bestValues = _mm256_blendv_epi8(bestValues, values, smaller);
+        bestIndices = _mm256_blendv_epi8(bestIndices, indices, smaller);
+    }
+
+    int values[8], lanes[8];
+    _mm256_storeu_si256((__m256i*)values, bestValues);
+    _mm256_storeu_si256((__m256i*)lanes, bestIndices);
+    return finishArgmin(data, n, j, values, lanes, 8);
+}
+#endif
+
+/**
+ * The kernel called `name` ("avx2", "sse4.1" or "scalar"), or null if
+ * it is unknown or this CPU cannot run it. An empty name picks the best.
+ */
+inline ArgminKernel findArgminKernel(const std::string& name) {
+#ifdef ARGMIN_X86
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    if (name.empty()) {
+        return avx2 ? argminAvx2 : sse41 ? argminSse41 : argminScalar;
+    }
+    if (name == "avx2") return avx2 ? argminAvx2 : nullptr;
+    if (name == "sse4.1") return sse41 ? argminSse41 : nullptr;
+#else
+    if (name.empty()) return argminScalar;
+#endif
+    return name == "scalar" ? argminScalar : nullptr;
+}
+
+// The best kernel for this CPU, chosen once
+inline ArgminKernel bestArgminKernel() {
+    static const ArgminKernel best = findArgminKernel("");
+    return best;
+}
+
+#endif
@@ -0,0 +1,709 @@
+#ifndef STEP_WRITER_H
+#define STEP_WRITER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <initializer_list>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "options.h"
+
+/**
+ * Buffered Step Writer
+ * Formats trace steps directly into a large preallocated buffer (no
+ * iostream formatting) and hands the buffer to cout's stream buffer only
+ * when it fills or the run ends. Flushes always happen on a step
+ * boundary, so every write is a self-contained chunk of whole steps
+ * (after the binary header) that a consumer can forward as it arrives.
+ *
+ * Usage:
+ *   StepWriter& out = startTrace(opts);
+ *   out.declareSteps({"compare", "swap"}, "i j value");
+ *   out.beginStep("compare");     // {"type":"compare"
+ *   out.field("i", 3);            // ,"i":3
+ *   out.endStep();                // }\n
+ *   ...
+ *   out.flush();                  // at the end of the run
+ *
+ * Two output formats are supported:
+ *
+ * NDJSON (default): one JSON object per line.
+ *
+ * Binary (--binary): a header followed by fixed-width records.
+ *   Header:
+ *     "ATRC", uint16 version (1), uint16 typeCount
+ *     per step type:  str name, uint8 fieldCount, then per field:
+ *                     uint8 kind, str name (+ str item1, str item2 for pairs)
+ *     zero padding to a multiple of 4 bytes
+ *     (str = uint8 length + bytes)
+ *   Field kinds:
+ *     0 int     one int32
+ *     1 flag    one int32, decoded as true/false
+ *     2 list    int32 count, then count int32 items
+ *     3 pairs   int32 count, then count (int32, int32) items, decoded as
+ *               objects keyed by item1/item2
+ *     4 int64   two int32 words, low then high
+ *   Record (20 bytes):
+ *     uint16 opcode (1-based index into the step types),
+ *     uint16 mask (bit f set when field f is present),
+ *     int32 words[4]
+ *   The present fields' values are laid out as one stream of int32 words
+ *   in declaration order. The first four words live in the record; any
+ *   further words follow in continuation records (opcode 0xFFFF, mask 0)
+ *   of four words each, zero padded.
+ *   All integers are little-endian.
+ *
+ * Fields must be written in the order their step type declares them.
+ *
+ * Every step type also has a trace level, given when it is declared
+ * (default TRACE_FULL). Steps above the run's verbosity are dropped:
+ *   full      every step
+ *   events    state changes (swaps, overwrites, updates, queue changes)
+ *             but no compares, checks, relaxations or explored edges
+ *   summary   per-pass markers and the result
+ *   result    the final result only
+ * Hot loops can test emits(level) to skip building a step altogether.
+ * With a step budget, the verbosity drops as the budget is spent: full
+ * detail up to half of it, events up to three quarters, summaries up to
+ * all of it, then results only. Result steps are never dropped or
+ * counted. Every drop is announced with a trace_level step whose level
+ * is the new verbosity (3 full ... 0 result).
+ *
+ * Keyframe index (see keyframes.h): the writer records the step number
+ * and byte offset of every keyframe step, and finishTrace ends the trace
+ * with one keyframe_offset(step, offset) step per keyframe followed by
+ * trace_index(keyframes, offset), where offset is where the first
+ * keyframe_offset step starts. Step numbers count every step written
+ * from 0; offsets count bytes from the start of the trace, header
+ * included. All four fields are 64-bit, so in binary traces each of these
+ * steps is exactly one record and trace_index is the last 20 bytes.
+ *
+ * Paging (pageBy): the trace can be cut into pages of a given number of
+ * steps. At the end of each page the writer flushes and calls a handler,
+ * which may block (suspending the algorithm right there) and returns the
+ * size of the next page. The engine uses this for trace sessions.
+ */
+
+enum TraceLevel {
+    TRACE_RESULT = 0,
+    TRACE_SUMMARY = 1,
+    TRACE_EVENTS = 2,
+    TRACE_FULL = 3
+};
+
+enum FieldKind {
+    FIELD_INT = 0,
+    FIELD_FLAG = 1,
+    FIELD_LIST = 2,
+    FIELD_PAIRS = 3,
+    FIELD_INT64 = 4
+};
+
+class StepWriter {
+public:
+    static const size_t DEFAULT_CHUNK = 1 << 18;
+
+    explicit StepWriter(size_t capacity = DEFAULT_CHUNK)
+        : buffer(capacity + RECORD_SLACK), size(0), threshold(capacity),
+          binary(false), headerWritten(false), firstItem(true),
+          verbosity(TRACE_FULL), filtering(false), skipping(false), stepBudget(0), stepsSpent(0),
+          stepsWritten(0), bytesFlushed(0), indexing(false), pageEnd(0),
+          currentType(0), fieldCursor(0), mask(0), listStart(0) {}
+
+    /**
+     * Reset for a new run: clears declared step types, selects the
+     * output format and sets how many bytes are buffered per chunk.
+     */
+    void reset(bool binaryFormat, size_t chunkBytes) {
+        size = 0;
+        threshold = chunkBytes;
+        binary = binaryFormat;
+        headerWritten = false;
+        types.clear();
+        if (pageEnd > 0) {
+            pageEnd -= stepsWritten;    // Pages count from the new trace's first step
+        }
+        stepsWritten = 0;
+        bytesFlushed = 0;
+        indexing = false;
+        keyframes.clear();
+        limit(TRACE_FULL, 0);
+    }
+
+    /**
+     * Set the verbosity and the step budget (0 for none). Call after
+     * reset and before the first step; a budget declares the trace_level
+     * step type.
+     */
+    void limit(TraceLevel level, long long budget) {
+        verbosity = level;
+        stepBudget = budget;
+        stepsSpent = 0;
+        filtering = level != TRACE_FULL || budget > 0;
+        if (budget > 0) {
+            declareSteps({"trace_level"}, "level", TRACE_RESULT);
+        }
+    }
+
+    // True when a step of this level would currently be written
+    bool emits(TraceLevel level) const {
+        return level <= verbosity;
+    }
+
+    // Level a step type was declared with; TRACE_FULL if it was not
+    TraceLevel levelOf(const char* name) const {
+        for (const StepType& type : types) {
+            if (strcmp(type.name, name) == 0) return type.level;
+        }
+        return TRACE_FULL;
+    }
+
+    bool hasBudget() const {
+        return stepBudget > 0;
+    }
+
+    bool isBinary() const {
+        return binary;
+    }
+
+    // Steps written so far in this run
+    long long stepCount() const {
+        return stepsWritten;
+    }
+
+    /**
+     * Turn this writer into a capture buffer for steps that will later be
+     * appended to target with appendSteps: same format and step types, no
+     * binary header, and never flushed to cout on its own. Lets parallel
+     * code trace into private writers and stitch them in a fixed order.
+     */
+    void captureFor(const StepWriter& target) {
+        size = 0;
+        threshold = SIZE_MAX;
+        binary = target.binary;
+        headerWritten = true;
+        types = target.types;
+        verbosity = target.verbosity;
+        filtering = verbosity != TRACE_FULL;
+        stepBudget = 0;
+        stepsWritten = 0;
+        indexing = false;
+        pageEnd = 0;
+    }
+
+    // Append every step captured by a writer set up with captureFor(*this)
+    void appendSteps(const StepWriter& captured) {
+        if (binary && !headerWritten) {
+            writeHeader();
+        }
+        append(captured.buffer.data(), captured.size);
+        stepsWritten += captured.stepsWritten;
+        if (size >= threshold) {
+            flush();
+        }
+    }
+
+    /**
+     * Declare step types that share a field layout.
+     * The spec lists field names separated by spaces; "name?" is a flag,
+     * "name[]" a list of ints, "name[a,b]" a list of {a, b} pairs and
+     * "name:64" a 64-bit int (plain fields are 32-bit in binary traces).
+     */
+    void declareSteps(std::initializer_list<const char*> names, const char* spec,
+                      TraceLevel level = TRACE_FULL) {
+        std::vector<FieldSpec> fields = parseSpec(spec);
+        for (const char* name : names) {
+            StepType type;
+            type.name = name;
+            type.fields = fields;
+            type.level = level;
+            types.push_back(type);
+        }
+    }
+
+    void beginStep(const char* type) {
+        skipping = false;
+        if (filtering) {
+            currentType = findType(type);
+            if (!emits(types[currentType].level)) {
+                skipping = true;
+                return;
+            }
+        }
+        if (binary) {
+            if (!filtering) currentType = findType(type);
+            fieldCursor = 0;
+            mask = 0;
+            words.clear();
+            return;
+        }
+        append("{\"type\":\"", 9);
+        append(type, strlen(type));
+        append('"');
+    }
+
+    void field(const char* key, long long value) {
+        if (skipping) return;
+        if (binary) {
+            markField(key);
+            words.push_back((int32_t)value);
+            if (types[currentType].fields[fieldCursor - 1].kind == FIELD_INT64) {
+                words.push_back((int32_t)((unsigned long long)value >> 32));
+            }
+            return;
+        }
+        appendKey(key);
+        appendInt(value);
+    }
+
+    // Boolean field that is only written when true, e.g. "backedge":true
+    void flag(const char* key) {
+        if (skipping) return;
+        if (binary) {
+            markField(key);
+            words.push_back(1);
+            return;
+        }
+        appendKey(key);
+        append("true", 4);
+    }
+
+    void beginList(const char* key) {
+        if (skipping) return;
+        firstItem = true;
+        if (binary) {
+            markField(key);
+            listStart = words.size();
+            words.push_back(0);
+            return;
+        }
+        appendKey(key);
+        append('[');
+    }
+
+    void item(long long value) {
+        if (skipping) return;
+        if (binary) {
+            words.push_back((int32_t)value);
+            words[listStart]++;
+            return;
+        }
+        separateItem();
+        appendInt(value);
+    }
+
+    // List item that is an object with two fields, e.g. {"node":3,"dist":7}
+    void pair(const char* key1, long long value1, const char* key2, long long value2) {
+        if (skipping) return;
+        if (binary) {
+            words.push_back((int32_t)value1);
+            words.push_back((int32_t)value2);
+            words[listStart]++;
+            return;
+        }
+        separateItem();
+        append("{\"", 2);
+        append(key1, strlen(key1));
+        append("\":", 2);
+        appendInt(value1);
+        appendKey(key2);
+        appendInt(value2);
+        append('}');
+    }
+
+    void endList() {
+        if (!binary && !skipping) {
+            append(']');
+        }
+    }
+
+    void endStep() {
+        if (skipping) return;
+        if (binary) {
+            writeRecords();
+        } else {
+            append("}\n", 2);
+        }
+        stepsWritten++;
+        if (size >= threshold) {
+            flush();
+        }
+        if (stepsWritten == pageEnd) {
+            endPage();
+        }
+        if (stepBudget > 0 && types[currentType].level != TRACE_RESULT) {
+            spendBudget();
+        }
+    }
+
+    void flush() {
+        if (binary && !headerWritten) {
+            writeHeader();
+        }
+        if (size > 0) {
+            std::cout.rdbuf()->sputn(buffer.data(), size);
+            bytesFlushed += size;
+            size = 0;
+        }
+        std::cout.flush();
+    }
+
+    /**
+     * Cut the trace into pages: once `steps` more steps are written, flush
+     * and call endOfPage, which returns the size of the next page (0 to
+     * stop paging). Survives reset, so it can be set before a program
+     * starts its trace.
+     */
+    void pageBy(long long steps, const std::function<long long()>& endOfPage) {
+        pageHandler = endOfPage;
+        pageEnd = steps > 0 ? stepsWritten + steps : 0;
+    }
+
+    // True when the trace is paged; steps must then be written in order
+    bool paged() const {
+        return pageEnd > 0;
+    }
+
+    /**
+     * Declare the keyframe index steps; finishTrace will write the index.
+     * Call before the first step.
+     */
+    void indexKeyframes() {
+        declareSteps({"keyframe_offset"}, "step:64 offset:64", TRACE_RESULT);
+        declareSteps({"trace_index"}, "keyframes:64 offset:64", TRACE_RESULT);
+        indexing = true;
+    }
+
+    // Begin a keyframe step of the given type and add it to the index
+    void beginKeyframe(const char* type) {
+        if (binary && !headerWritten) {
+            writeHeader();
+        }
+        keyframes.push_back(Keyframe());
+        keyframes.back().step = stepsWritten;
+        keyframes.back().offset = bytesFlushed + size;
+        beginStep(type);
+    }
+
+    /**
+     * End of the run: write the keyframe index (when declared) and flush.
+     */
+    void finishTrace() {
+        if (indexing) {
+            if (binary && !headerWritten) {
+                writeHeader();
+            }
+            long long indexOffset = bytesFlushed + size;
+            for (const Keyframe& keyframe : keyframes) {
+                beginStep("keyframe_offset");
+                field("step", keyframe.step);
+                field("offset", keyframe.offset);
+                endStep();
+            }
+            beginStep("trace_index");
+            field("keyframes", (long long)keyframes.size());
+            field("offset", indexOffset);
+            endStep();
+        }
+        flush();
+    }
+
+private:
+    // Room kept past the flush threshold so a typical step never reallocates
+    static const size_t RECORD_SLACK = 4096;
+    static const uint16_t CONTINUATION = 0xFFFF;
+
+    struct FieldSpec {
+        std::string name;
+        FieldKind kind;
+        std::string item1, item2;
+    };
+
+    struct StepType {
+        const char* name;
+        std::vector<FieldSpec> fields;
+        TraceLevel level;
+    };
+
+    struct Keyframe {
+        long long step;
+        long long offset;
+    };
+
+    std::vector<char> buffer;
+    size_t size;
+    size_t threshold;
+    bool binary;
+    bool headerWritten;
+    bool firstItem;
+
+    TraceLevel verbosity;
+    bool filtering;             // Steps may be dropped, so look up each type's level
+    bool skipping;              // The current step is dropped
+    long long stepBudget;
+    long long stepsSpent;
+
+    long long stepsWritten;
+    long long bytesFlushed;
+    bool indexing;              // finishTrace writes the keyframe index
+    std::vector<Keyframe> keyframes;
+
+    long long pageEnd;          // Step count that ends the current page, 0 when not paging
+    std::function<long long()> pageHandler;
+
+    std::vector<StepType> types;
+    size_t currentType;
+    size_t fieldCursor;
+    uint16_t mask;
+    std::vector<int32_t> words;
+    size_t listStart;
+
+    static std::vector<FieldSpec> parseSpec(const char* spec) {
+        std::vector<FieldSpec> fields;
+        std::string text(spec);
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find(' ', pos);
+            if (end == std::string::npos) end = text.size();
+            std::string token = text.substr(pos, end - pos);
+            pos = end + 1;
+            if (token.empty()) continue;
+
+            FieldSpec field;
+            field.kind = FIELD_INT;
+            size_t bracket = token.find('[');
+            if (bracket != std::string::npos) {
+                std::string items = token.substr(bracket + 1, token.size() - bracket - 2);
+                size_t comma = items.find(',');
+                if (comma == std::string::npos) {
+                    field.kind = FIELD_LIST;
+                } else {
+                    field.kind = FIELD_PAIRS;
+                    field.item1 = items.substr(0, comma);
+                    field.item2 = items.substr(comma + 1);
+                }
+                token = token.substr(0, bracket);
+            } else if (token[token.size() - 1] == '?') {
+                field.kind = FIELD_FLAG;
+                token = token.substr(0, token.size() - 1);
+            } else if (token.size() > 3 && token.compare(token.size() - 3, 3, ":64") == 0) {
+                field.kind = FIELD_INT64;
+                token = token.substr(0, token.size() - 3);
+            }
+            field.name = token;
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    size_t findType(const char* name) {
+        // Callers pass string literals, so a pointer match is the common case
+        for (size_t i = 0; i < types.size(); i++) {
+            if (types[i].name == name) return i;
+        }
+        for (size_t i = 0; i < types.size(); i++) {
+            if (strcmp(types[i].name, name) == 0) return i;
+        }
+        std::cerr << "StepWriter: undeclared step type '" << name << "'" << std::endl;
+        abort();
+    }
+
+    void endPage() {
+        flush();
+        long long next = pageHandler();
+        pageEnd = next > 0 ? stepsWritten + next : 0;
+    }
+
+    void spendBudget() {
+        stepsSpent++;
+        TraceLevel allowed = stepsSpent >= stepBudget ? TRACE_RESULT
+                           : stepsSpent * 4 >= stepBudget * 3 ? TRACE_SUMMARY
+                           : stepsSpent * 2 >= stepBudget ? TRACE_EVENTS
+                           : TRACE_FULL;
+        if (allowed < verbosity) {
+            verbosity = allowed;
+            beginStep("trace_level");
+            field("level", verbosity);
+            endStep();
+        }
+    }
+
+    void markField(const char* key) {
+        const std::vector<FieldSpec>& fields = types[currentType].fields;
+        while (fieldCursor < fields.size() && fields[fieldCursor].name != key) {
+            fieldCursor++;
+        }
+        if (fieldCursor == fields.size()) {
+            std::cerr << "StepWriter: field '" << key << "' not declared for '"
+                      << types[currentType].name << "'" << std::endl;
+            abort();
+        }
+        mask |= (uint16_t)(1u << fieldCursor);
+        fieldCursor++;
+    }
+
+    void writeHeader() {
+        // The header goes in front of anything already buffered
+        std::vector<char> header;
+        header.insert(header.end(), "ATRC", "ATRC" + 4);
+        putUint16(header, 1);
+        putUint16(header, (uint16_t)types.size());
+        for (const StepType& type : types) {
+            putString(header, type.name);
+            header.push_back((char)type.fields.size());
+            for (const FieldSpec& field : type.fields) {
+                header.push_back((char)field.kind);
+                putString(header, field.name);
+                if (field.kind == FIELD_PAIRS) {
+                    putString(header, field.item1);
+                    putString(header, field.item2);
+                }
+            }
+        }
+        while (header.size() % 4 != 0) {
+            header.push_back(0);
+        }
+
+        reserve(header.size());
+        memmove(buffer.data() + header.size(), buffer.data(), size);
+        memcpy(buffer.data(), header.data(), header.size());
+        size += header.size();
+        headerWritten = true;
+    }
+
+    void writeRecords() {
+        if (!headerWritten) {
+            writeHeader();
+        }
+        uint16_t opcode = (uint16_t)(currentType + 1);
+        size_t count = words.size();
+        size_t records = count <= 4 ? 1 : 1 + (count - 4 + 3) / 4;
+        reserve(records * 20);
+
+        size_t next = 0;
+        for (size_t r = 0; r < records; r++) {
+            putRecordUint16(r == 0 ? opcode : CONTINUATION);
+            putRecordUint16(r == 0 ? mask : 0);
+            for (int w = 0; w < 4; w++) {
+                putRecordInt32(next < count ? words[next] : 0);
+                next++;
+            }
+        }
+    }
+
+    static void putUint16(std::vector<char>& out, uint16_t value) {
+        out.push_back((char)(value & 0xff));
+        out.push_back((char)(value >> 8));
+    }
+
+    static void putString(std::vector<char>& out, const std::string& text) {
+        out.push_back((char)text.size());
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    void putRecordUint16(uint16_t value) {
+        buffer[size++] = (char)(value & 0xff);
+        buffer[size++] = (char)(value >> 8);
+    }
+
+    void putRecordInt32(int32_t value) {
+        uint32_t bits = (uint32_t)value;
+        buffer[size++] = (char)(bits & 0xff);
+        buffer[size++] = (char)((bits >> 8) & 0xff);
+        buffer[size++] = (char)((bits >> 16) & 0xff);
+        buffer[size++] = (char)(bits >> 24);
+    }
+
+    void reserve(size_t extra) {
+        if (size + extra > buffer.size()) {
+            buffer.resize((size + extra) * 2);
+        }
+    }
+
+    void append(char c) {
+        reserve(1);
+        buffer[size++] = c;
+    }
+
+    void append(const char* text, size_t length) {
+        reserve(length);
+        memcpy(buffer.data() + size, text, length);
+        size += length;
+    }
+
+    void appendKey(const char* key) {
+        append(",\"", 2);
+        append(key, strlen(key));
+        append("\":", 2);
+    }
+
+    void separateItem() {
+        if (!firstItem) append(',');
+        firstItem = false;
+    }
+
+    void appendInt(long long value) {
+        reserve(21);
+        char digits[20];
+        int count = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value
+                                                 : (unsigned long long)value;
+        do {
+            digits[count++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+
+        char* out = buffer.data() + size;
+        if (value < 0) *out++ = '-';
+        while (count > 0) *out++ = digits[--count];
+        size = out - buffer.data();
+    }
+};
+
+/**
+ * The writer shared by every algorithm in this process.
+ */
+inline StepWriter& stepWriter() {
+    static StepWriter writer;
+    return writer;
+}
+
+/**
+ * Prepare the shared writer for a run using the trace options:
+ *   --binary       emit the binary record format instead of NDJSON
+ *   --chunk=<n>    flush every n bytes (default 256 KiB); smaller chunks
+ *                  lower the time to first step when streaming
+ *   --verbosity=full|events|summary|result
+ *                  which steps to write (see the trace levels above)
+ *   --max-steps=<n>
+ *                  step budget that coarsens the trace as it is spent
+ *   --metrics      end the trace with a metrics step (see metrics.h)
+ */
+inline StepWriter& startTrace(const Options& opts) {
+    StepWriter& out = stepWriter();
+    long long chunk = opts.getInt("chunk", StepWriter::DEFAULT_CHUNK);
+    out.reset(opts.has("binary"), chunk > 0 ? (size_t)chunk : StepWriter::DEFAULT_CHUNK);
+
+    std::string verbosity = opts.get("verbosity", "full");
+    TraceLevel level = verbosity == "result" ? TRACE_RESULT
+                     : verbosity == "summary" ? TRACE_SUMMARY
+                     : verbosity == "events" ? TRACE_EVENTS
+                     : TRACE_FULL;
+    out.limit(level, std::max(0LL, opts.getInt("max-steps", 0)));
+
+    // Written last by finishMetrics (metrics.h)
+    if (opts.has("metrics")) {
+        out.declareSteps({"metrics"},
+                         "comparisons:64 swaps:64 overwrites:64 relaxations:64 pushes:64 pops:64 "
+                         "stale_pops:64 parse_ns:64 build_ns:64 run_ns:64 emit_ns:64 "
+                         "cycles:64 instructions:64 cache_misses:64", TRACE_RESULT);
+    }
+    return out;
+}
+
+#endif
+
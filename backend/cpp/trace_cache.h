@@ -0,0 +1,377 @@
+#ifndef TRACE_CACHE_H
+#define TRACE_CACHE_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <unistd.h>
+#include <utime.h>
+#include <sys/mman.h>
+#endif
+
+/**
+ * Trace Cache
+ * On-disk cache of complete traces for the engine, so a repeated request
+ * replays the stored trace instead of running the algorithm and
+ * formatting its steps again.
+ *
+ * The key is the engine build (TRACE_CACHE_BUILD) on a line of its own,
+ * then the request in normal form: the algorithm name, its flags (the
+ * last value of each, sorted by name, exactly as Options would see them)
+ * and its positional arguments as the integers atoi reads. It is hashed
+ * (MurmurHash64A) to name the file <dir>/<hash>.trace:
+ *   "ATCH", uint32 version (2), uint32 key length, key bytes,
+ *   then the trace as it was flushed: per chunk uint32 length + bytes
+ * The stored key is compared on every hit, so a hash collision is a miss.
+ * A rebuilt engine, whose algorithms or trace format may have changed,
+ * therefore never replays an older build's traces; they are left to age
+ * out of the budget.
+ * Chunks are replayed with the boundaries they were written with, so each
+ * still holds whole steps. All integers are little-endian.
+ *
+ * Files are written to a temporary name and renamed when complete, so
+ * concurrent engine workers sharing the directory never see a partial
+ * trace. A file's modification time is its last use: hits touch it, and
+ * after each insert the least recently used files are deleted until the
+ * directory fits the budget. A trace larger than the whole budget is not
+ * stored.
+ *
+ * Requests are not cached when their output depends on more than the
+ * request text: --metrics (timings), --graph=<file>, --coords-file=<file>
+ * and --stdin.
+ */
+
+// Compile time of the engine unless the build names itself (e.g. with a
+// hash of the sources): -DTRACE_CACHE_BUILD='"<id>"'
+#ifndef TRACE_CACHE_BUILD
+#define TRACE_CACHE_BUILD __DATE__ " " __TIME__
+#endif
+
+class TraceCache {
+public:
+    static const uint64_t DEFAULT_BUDGET = 1ULL << 30;
+
+    TraceCache() : budget(DEFAULT_BUDGET), recording(nullptr), recorded(0) {}
+
+    ~TraceCache() {
+        finishRecording(false);
+    }
+
+    /**
+     * Use `path` (created if missing) for the cache with a budget in bytes.
+     */
+    bool open(const std::string& path, uint64_t budgetBytes) {
+#ifdef _WIN32
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+            return false;
+        }
+        dir = path;
+        budget = budgetBytes;
+        return true;
+    }
+
+    bool enabled() const {
+        return !dir.empty();
+    }
+
+    /**
+     * Cache key of a request (args[0] is the algorithm): this build and the
+     * request's normal form; false when the request must not be cached.
+     */
+    static bool normalize(const std::vector<std::string>& args, std::string& key) {
+        std::map<std::string, std::string> flags;
+        std::string positional;
+        for (size_t i = 1; i < args.size(); i++) {
+            const std::string& arg = args[i];
+            if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+                size_t equals = arg.find('=');
+                std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+                if (name == "metrics" || name == "graph" || name == "stdin" || name == "coords-file") {
+                    return false;
+                }
+                flags[name] = equals == std::string::npos ? "" : arg.substr(equals);
+            } else {
+                positional += ' ';
+                positional += std::to_string(atoi(arg.c_str()));
+            }
+        }
+
+        key = TRACE_CACHE_BUILD "\n";
+        key += args.empty() ? "" : args[0];
+        for (const std::pair<const std::string, std::string>& flag : flags) {
+            key += " --" + flag.first + flag.second;
+        }
+        key += " :";
+        key += positional;
+        return true;
+    }
+
+    /**
+     * Pass the chunks stored for `key` to `send`, in order. Returns false
+     * on a miss (nothing was sent).
+     */
+    bool replay(const std::string& key, const std::function<void(const char*, size_t)>& send) {
+        std::string path = pathFor(key);
+        MappedFile file;
+        if (!file.open(path)) return false;
+
+        size_t start = 12 + key.size();
+        if (file.size < start || memcmp(file.data, "ATCH", 4) != 0 || getUint32(file.data + 4) != FILE_VERSION ||
+            getUint32(file.data + 8) != key.size() || memcmp(file.data + 12, key.data(), key.size()) != 0) {
+            return false;
+        }
+
+        // Check the chunk layout before sending anything
+        std::vector<std::pair<size_t, size_t>> chunks;
+        for (size_t at = start; at < file.size;) {
+            if (file.size - at < 4) return false;
+            size_t length = getUint32(file.data + at);
+            if (file.size - at - 4 < length) return false;
+            chunks.push_back(std::make_pair(at + 4, length));
+            at += 4 + length;
+        }
+
+        utime(path.c_str(), nullptr);
+        for (const std::pair<size_t, size_t>& chunk : chunks) {
+            send(file.data + chunk.first, chunk.second);
+        }
+        return true;
+    }
+
+    /**
+     * Record the trace of a request that missed; the chunks passed to
+     * record are stored when finishRecording(true) is called.
+     */
+    void startRecording(const std::string& key) {
+        finishRecording(false);
+        recordingKey = key;
+        recordingPath = pathFor(key) + ".tmp" + std::to_string((long long)getpid());
+        recording = fopen(recordingPath.c_str(), "wb");
+        if (!recording) return;
+
+        char header[12];
+        memcpy(header, "ATCH", 4);
+        putUint32(header + 4, FILE_VERSION);
+        putUint32(header + 8, (uint32_t)key.size());
+        fwrite(header, 1, sizeof(header), recording);
+        fwrite(key.data(), 1, key.size(), recording);
+        recorded = sizeof(header) + key.size();
+    }
+
+    void record(const char* data, size_t size) {
+        if (!recording) return;
+        recorded += 4 + size;
+        if (recorded > budget) {
+            // Too large to ever be kept
+            finishRecording(false);
+            return;
+        }
+        char length[4];
+        putUint32(length, (uint32_t)size);
+        fwrite(length, 1, sizeof(length), recording);
+        fwrite(data, 1, size, recording);
+    }
+
+    /**
+     * Store the recorded trace under its key (if keep and every write
+     * succeeded) and evict old entries, or drop it.
+     */
+    void finishRecording(bool keep) {
+        if (!recording) return;
+        bool written = !ferror(recording);
+        written = fclose(recording) == 0 && written;
+        recording = nullptr;
+
+        std::string path = pathFor(recordingKey);
+        if (keep && written) {
+#ifdef _WIN32
+            remove(path.c_str());   // rename does not replace on Windows
+#endif
+            if (rename(recordingPath.c_str(), path.c_str()) == 0) {
+                evict();
+                return;
+            }
+        }
+        remove(recordingPath.c_str());
+    }
+
+private:
+    static const uint32_t FILE_VERSION = 2;
+
+    std::string dir;
+    uint64_t budget;
+    FILE* recording;
+    std::string recordingKey;
+    std::string recordingPath;
+    uint64_t recorded;
+
+    // Read-only view of a whole file: mapped where possible, else read
+    struct MappedFile {
+        const char* data;
+        size_t size;
+        std::vector<char> copy;
+#ifndef _WIN32
+        void* mapping;
+#endif
+
+        MappedFile() : data(nullptr), size(0) {
+#ifndef _WIN32
+            mapping = nullptr;
+#endif
+        }
+
+        ~MappedFile() {
+#ifndef _WIN32
+            if (mapping) munmap(mapping, size);
+#endif
+        }
+
+        bool open(const std::string& path) {
+#ifdef _WIN32
+            int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+#endif
+            if (fd < 0) return false;
+            struct stat info;
+            bool ok = fstat(fd, &info) == 0 && info.st_size > 0;
+            if (ok) {
+                size = (size_t)info.st_size;
+#ifdef _WIN32
+                copy.resize(size);
+                ok = _read(fd, copy.data(), (unsigned int)size) == (int)size;
+                data = copy.data();
+#else
+                mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED) {
+                    mapping = nullptr;
+                    ok = false;
+                } else {
+                    madvise(mapping, size, MADV_SEQUENTIAL);
+                    data = (const char*)mapping;
+                }
+#endif
+            }
+#ifdef _WIN32
+            _close(fd);
+#else
+            close(fd);
+#endif
+            return ok;
+        }
+    };
+
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        time_t lastUse;
+    };
+
+    std::string pathFor(const std::string& key) const {
+        char name[24];
+        snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash(key.data(), key.size()));
+        return dir + "/" + name + ".trace";
+    }
+
+    // Delete the least recently used traces until the rest fit the budget
+    void evict() {
+        DIR* listing = opendir(dir.c_str());
+        if (!listing) return;
+        std::vector<Entry> entries;
+        uint64_t total = 0;
+        while (dirent* item = readdir(listing)) {
+            std::string name = item->d_name;
+            if (name.size() < 6 || name.compare(name.size() - 6, 6, ".trace") != 0) continue;
+            Entry entry;
+            entry.path = dir + "/" + name;
+            struct stat info;
+            if (stat(entry.path.c_str(), &info) != 0) continue;
+            entry.size = (uint64_t)info.st_size;
+            entry.lastUse = info.st_mtime;
+            entries.push_back(entry);
+            total += entry.size;
+        }
+        closedir(listing);
+
+        sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.lastUse < b.lastUse;
+        });
+        for (size_t i = 0; i < entries.size() && total > budget; i++) {
+            if (remove(entries[i].path.c_str()) == 0) {
+                total -= entries[i].size;
+            }
+        }
+    }
+
+    static void putUint32(char* out, uint32_t value) {
+        out[0] = (char)(value & 0xff);
+        out[1] = (char)((value >> 8) & 0xff);
+        out[2] = (char)((value >> 16) & 0xff);
+        out[3] = (char)((value >> 24) & 0xff);
+    }
+
+    static uint32_t getUint32(const char* in) {
+        const unsigned char* p = (const unsigned char*)in;
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // MurmurHash64A: 8 bytes per step, good spread on short keys
+    static uint64_t hash(const char* data, size_t size) {
+        const uint64_t m = 0xc6a4a7935bd1e995ULL;
+        const int r = 47;
+        uint64_t h = 0x9747b28cULL ^ (size * m);
+
+        size_t words = size / 8;
+        for (size_t w = 0; w < words; w++) {
+            uint64_t k;
+            memcpy(&k, data + w * 8, 8);
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+            h ^= k;
+            h *= m;
+        }
+
+        const unsigned char* tail = (const unsigned char*)data + words * 8;
+        switch (size & 7) {
+            case 7: h ^= (uint64_t)tail[6] << 48;  // fall through
+            case 6: h ^= (uint64_t)tail[5] << 40;  // fall through
+            case 5: h ^= (uint64_t)tail[4] << 32;  // fall through
+            case 4: h ^= (uint64_t)tail[3] << 24;  // fall through
+            case 3: h ^= (uint64_t)tail[2] << 16;  // fall through
+            case 2: h ^= (uint64_t)tail[1] << 8;   // fall through
+            case 1: h ^= (uint64_t)tail[0];
+                    h *= m;
+        }
+
+        h ^= h >> r;
+        h *= m;
+        h ^= h >> r;
+        return h;
+    }
+};
+
+#endif
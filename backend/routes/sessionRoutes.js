@@ -0,0 +1,12 @@
+import express from 'express';
+import { deleteSession, getNextPage } from '../controllers/sessionController.js';
+
+const router = express.Router();
+
+// POST /api/session/:id/next
+router.post('/:id/next', getNextPage);
+
+// DELETE /api/session/:id
+router.delete('/:id', deleteSession);
+
+export default router;
@@ -3,6 +3,8 @@ import { runBubbleSort } from '../controllers/bubbleController.js';
 import { runSelectionSort } from '../controllers/selectionController.js';
 import { runInsertionSort } from '../controllers/insertionController.js';
 import { runMergeSort } from '../controllers/mergeController.js';
+import { runPdqSort } from '../controllers/pdqsortController.js';
+import { runRadixSort } from '../controllers/radixController.js';
 
 const router = express.Router();
 
@@ -18,5 +20,11 @@ router.post('/insertion', runInsertionSort);
 // POST /api/sort/merge
 router.post('/merge', runMergeSort);
 
+// POST /api/sort/pdqsort
+router.post('/pdqsort', runPdqSort);
+
+// POST /api/sort/radix
+router.post('/radix', runRadixSort);
+
 export default router;
 
@@ -2,6 +2,7 @@ import express from 'express';
 import cors from 'cors';
 import sortRoutes from './routes/sortRoutes.js';
 import graphRoutes from './routes/graphRoutes.js';
+import sessionRoutes from './routes/sessionRoutes.js';
 
 const app = express();
 const PORT = process.env.PORT || 5000;
@@ -14,6 +15,7 @@ app.use(express.json());
 // Routes
 app.use('/api/sort', sortRoutes);
 app.use('/api/graph', graphRoutes);
+app.use('/api/session', sessionRoutes);
 
 // Health check endpoint
 app.get('/api/health', (req, res) => {
@@ -0,0 +1,359 @@
+import { spawn } from 'child_process';
+import fs from 'fs';
+import net from 'net';
+import os from 'os';
+import path from 'path';
+import { fileURLToPath } from 'url';
+
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = path.dirname(__filename);
+
+const isWindows = process.platform === 'win32';
+const buildDir = path.join(__dirname, '../cpp/build');
+const engineExecutable = path.join(buildDir, isWindows ? 'engine.exe' : 'engine');
+
+const FRAME_DATA = 0;
+const FRAME_END = 1;
+const FRAME_PAGE = 2;
+
+const poolSize = parseInt(process.env.ENGINE_WORKERS, 10) || Math.min(os.cpus().length, 4);
+const engineSocket = process.env.ENGINE_SOCKET;
+
+// Trace cache shared by the pooled engines (see cpp/trace_cache.h)
+const engineArgs = process.env.ENGINE_CACHE_DIR
+  ? ['--cache', process.env.ENGINE_CACHE_DIR,
+     ...(process.env.ENGINE_CACHE_BYTES ? ['--cache-size', process.env.ENGINE_CACHE_BYTES] : [])]
+  : [];
+
+/**
+ * One warm engine process (or socket connection).
+ * The engine serves one request at a time, so each worker has at most
+ * one request in flight. A request resolves with `more: true` when the
+ * engine ended a page of a trace session instead of the whole trace.
+ */
+export class EngineWorker {
+  constructor(onExit) {
+    this.current = null;
+    this.buffer = Buffer.alloc(0);
+    this.chunks = [];
+    this.alive = true;
+
+    if (engineSocket) {
+      this.input = this.output = net.connect(engineSocket);
+      this.output.on('close', () => this.handleExit('socket closed', onExit));
+    } else {
+      this.process = spawn(engineExecutable, engineArgs, { stdio: ['pipe', 'pipe', 'pipe'] });
+      this.input = this.process.stdin;
+      this.output = this.process.stdout;
+      this.process.stderr.on('data', data => console.error('C++ engine stderr:', data.toString()));
+      this.process.on('exit', code => this.handleExit(`exited with code ${code}`, onExit));
+    }
+
+    this.input.on('error', error => this.handleExit(error.message, onExit));
+    this.output.on('data', data => this.handleData(data));
+  }
+
+  run(name, args, onData) {
+    return new Promise((resolve, reject) => {
+      this.current = { name, resolve, reject, onData };
+      this.chunks = [];
+
+      const payload = Buffer.from([name, ...args].join(' '));
+      const header = Buffer.alloc(4);
+      header.writeUInt32LE(payload.length, 0);
+      this.input.write(Buffer.concat([header, payload]));
+    });
+  }
+
+  handleData(data) {
+    this.buffer = this.buffer.length ? Buffer.concat([this.buffer, data]) : data;
+
+    while (this.buffer.length >= 8) {
+      const length = this.buffer.readUInt32LE(0);
+      const kind = this.buffer.readUInt32LE(4);
+      if (this.buffer.length < 8 + length) break;
+
+      const payload = this.buffer.subarray(8, 8 + length);
+      this.buffer = this.buffer.subarray(8 + length);
+
+      if (kind === FRAME_DATA) {
+        this.forward(payload);
+      } else if (kind === FRAME_END || kind === FRAME_PAGE) {
+        const code = kind === FRAME_END ? payload.readInt32LE(0) : 0;
+        const stderr = kind === FRAME_END ? payload.subarray(4).toString() : '';
+        const request = this.current;
+        const stdout = Buffer.concat(this.chunks);
+        this.current = null;
+        this.chunks = [];
+
+        if (code === 0) {
+          request.resolve({ stdout, stderr, more: kind === FRAME_PAGE });
+        } else {
+          request.reject(new Error(`${request.name} exited with code ${code}: ${stderr.trim()}`));
+        }
+      }
+    }
+  }
+
+  /**
+   * Hand a trace chunk to the request's consumer, or keep it if the
+   * caller wants the whole trace. A consumer may return a promise to
+   * apply backpressure; the engine is paused until it resolves.
+   */
+  forward(payload) {
+    const { onData } = this.current;
+    if (!onData) {
+      this.chunks.push(payload);
+      return;
+    }
+
+    const wait = onData(payload);
+    if (wait && typeof wait.then === 'function') {
+      this.output.pause();
+      wait.then(() => this.output.resume());
+    }
+  }
+
+  /**
+   * Drop the request in flight: the engine may be deep in a long trace,
+   * so its process (or connection) goes and the pool starts a fresh
+   * worker for the next request.
+   */
+  abort() {
+    if (this.process) {
+      this.process.kill();
+    } else {
+      this.output.destroy();
+    }
+  }
+
+  handleExit(reason, onExit) {
+    if (!this.alive) return;
+    this.alive = false;
+    if (this.current) {
+      this.current.reject(new Error(`C++ engine ${reason}`));
+      this.current = null;
+    }
+    onExit(this);
+  }
+}
+
+/**
+ * Fixed-size pool of warm engine workers with a FIFO wait queue.
+ * Workers are started lazily and replaced if they die.
+ */
+class EnginePool {
+  constructor(size) {
+    this.size = size;
+    this.workers = [];
+    this.idle = [];
+    this.waiting = [];
+  }
+
+  acquire() {
+    if (this.idle.length > 0) {
+      return Promise.resolve(this.idle.pop());
+    }
+    if (this.workers.length < this.size) {
+      const worker = new EngineWorker(dead => this.remove(dead));
+      this.workers.push(worker);
+      return Promise.resolve(worker);
+    }
+    return new Promise(resolve => this.waiting.push(resolve));
+  }
+
+  release(worker) {
+    if (!worker.alive) return;
+    const next = this.waiting.shift();
+    if (next) {
+      next(worker);
+    } else {
+      this.idle.push(worker);
+    }
+  }
+
+  remove(worker) {
+    this.workers = this.workers.filter(w => w !== worker);
+    this.idle = this.idle.filter(w => w !== worker);
+
+    // Let a queued request start a replacement worker
+    const next = this.waiting.shift();
+    if (next) {
+      this.acquire().then(next);
+    }
+  }
+
+  async run(name, args, onData, signal) {
+    const worker = await this.acquire();
+    const abort = () => worker.abort();
+    try {
+      if (signal) {
+        // Gave up while queued: the worker has not started, so keep it
+        if (signal.aborted) throw new Error(`${name} was aborted`);
+        signal.addEventListener('abort', abort);
+      }
+      return await worker.run(name, args, onData);
+    } finally {
+      if (signal) signal.removeEventListener('abort', abort);
+      this.release(worker);
+    }
+  }
+}
+
+const pool = new EnginePool(poolSize);
+
+// Largest value the C++ programs read into an int
+const INT_MAX = 2147483647;
+
+// Kinds of option value: a bare flag, one of a few words, an integer range
+// (that may also be given as a bare flag for the program's default) or text
+const flag = { flag: true };
+const oneOf = (...values) => ({ values });
+const integer = (min, max, bare = false) => ({ min, max, flag: bare });
+const text = pattern => ({ pattern });
+
+// Trace options every program reads (step_writer.h, keyframes.h, metrics.h)
+const traceOptions = {
+  verbosity: oneOf('full', 'events', 'summary', 'result'),
+  binary: flag,
+  'max-steps': integer(1, INT_MAX),
+  keyframes: integer(64, INT_MAX, true),
+  metrics: flag
+};
+
+// Queue and stack deltas (frontier_deltas.h)
+const frontierOptions = {
+  'queue-deltas': flag,
+  'snapshot-every': integer(16, INT_MAX)
+};
+
+/**
+ * Options a client may set, per algorithm. Options that read files on the
+ * server (--graph, --stdin, --coords-file) or only tune how the server
+ * spends its resources (--chunk, --threads) are never passed through, and
+ * ranges keep a client from asking for output far bigger than the trace.
+ */
+const publicOptions = {
+  bubble: traceOptions,
+  selection: { ...traceOptions, simd: oneOf('avx2', 'sse4.1', 'scalar') },
+  insertion: traceOptions,
+  merge: { ...traceOptions, natural: flag, parallel: flag },
+  pdqsort: traceOptions,
+  radix: traceOptions,
+  bfs: { ...traceOptions, ...frontierOptions, 'direction-optimizing': flag },
+  dfs: { ...traceOptions, ...frontierOptions, 'stack-snapshots': flag },
+  dijkstra: {
+    ...traceOptions,
+    ...frontierOptions,
+    heap: oneOf('binary', 'dary', 'radix'),
+    'delta-stepping': integer(1, INT_MAX, true),
+    'bucket-trace': flag,
+    target: integer(0, INT_MAX),
+    bidirectional: flag,
+    coords: text(/^[-+\d.e]+(,[-+\d.e]+)*$/),
+    heuristic: oneOf('euclidean', 'manhattan')
+  },
+  bellman_ford: { ...traceOptions, 'early-exit': flag, spfa: flag, parallel: flag },
+  floyd_warshall: { ...traceOptions, blocked: flag, block: integer(8, 256), scalar: flag, johnson: flag }
+};
+
+// The command-line flag for one option, or null if the value is not allowed
+const optionFlag = (name, spec, value) => {
+  if (value === true) return spec.flag ? `--${name}` : null;
+  const allowed = spec.values ? spec.values.includes(value)
+    : spec.pattern ? typeof value === 'string' && spec.pattern.test(value)
+    : spec.min !== undefined && Number.isInteger(value) && value >= spec.min && value <= spec.max;
+  return allowed ? `--${name}=${value}` : null;
+};
+
+/**
+ * Convert a request's `options` object into C++ command-line flags for an
+ * algorithm, e.g. { binary: true, heap: 'radix' } -> ['--binary', '--heap=radix'].
+ * Options set to false, null or undefined are left out. Returns null if
+ * any other option is not one of the algorithm's public options with an
+ * allowed value.
+ */
+export const optionArgs = (name, options) => {
+  if (options === undefined || options === null) return [];
+  if (typeof options !== 'object') return null;
+
+  const specs = publicOptions[name] || {};
+  const args = [];
+  for (const [option, value] of Object.entries(options)) {
+    if (value === false || value === null || value === undefined) continue;
+    const arg = Object.prototype.hasOwnProperty.call(specs, option) ? optionFlag(option, specs[option], value) : null;
+    if (arg === null) return null;
+    args.push(arg);
+  }
+  return args;
+};
+
+/**
+ * Positional C++ arguments for a list of values, or null unless every
+ * value is an integer the programs can read. The engine splits requests
+ * on whitespace, so any other value could smuggle in extra flags.
+ */
+export const integerArgs = values => (
+  values.every(value => Number.isInteger(value) && Math.abs(value) <= INT_MAX) ? values.map(String) : null
+);
+
+/**
+ * Run a standalone algorithm program, streaming or collecting its stdout.
+ */
+const runStandalone = (name, args, onData, signal) => new Promise((resolve, reject) => {
+  const executableName = isWindows ? `${name}.exe` : name;
+  const child = spawn(path.join(buildDir, executableName), args);
+  const chunks = [];
+  let stderr = '';
+
+  // Nothing is sent on stdin; an open pipe would leave a reader waiting
+  child.stdin.end();
+
+  if (signal) {
+    const abort = () => child.kill();
+    if (signal.aborted) abort();
+    signal.addEventListener('abort', abort);
+    child.on('close', () => signal.removeEventListener('abort', abort));
+  }
+
+  child.stdout.on('data', data => {
+    if (!onData) {
+      chunks.push(data);
+      return;
+    }
+    const wait = onData(data);
+    if (wait && typeof wait.then === 'function') {
+      child.stdout.pause();
+      wait.then(() => child.stdout.resume());
+    }
+  });
+  child.stderr.on('data', data => { stderr += data.toString(); });
+  child.on('error', reject);
+  child.on('close', code => {
+    if (code === 0) {
+      resolve({ stdout: Buffer.concat(chunks), stderr });
+    } else {
+      reject(new Error(`${name} exited with code ${code}: ${stderr.trim()}`));
+    }
+  });
+});
+
+// True when requests go to the engine rather than standalone programs
+export const engineAvailable = () => Boolean(engineSocket) || fs.existsSync(engineExecutable);
+
+/**
+ * Run an algorithm and return { stdout, stderr }, where stdout is a
+ * Buffer holding the NDJSON or binary trace. If `onData` is given, trace
+ * chunks are passed to it as they are produced instead (stdout is then
+ * empty); there is no limit on the trace size.
+ * Aborting `signal` stops the algorithm and rejects, e.g. when the client
+ * of a stream went away.
+ * Uses the warm engine pool when the engine binary (or socket) is available,
+ * otherwise falls back to running the standalone program.
+ */
+export const runAlgorithm = async (name, args, onData, signal) => {
+  if (engineAvailable()) {
+    return pool.run(name, args, onData, signal);
+  }
+  return runStandalone(name, args, onData, signal);
+};
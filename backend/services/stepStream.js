@@ -0,0 +1,131 @@
+import { runAlgorithm } from './enginePool.js';
+import { StepDecoder } from './traceDecoder.js';
+import { nextPage, openSession, sessionsAvailable } from './traceSessions.js';
+
+// Largest page a client may ask for, in steps
+export const MAX_PAGE_SIZE = 100000;
+
+// Clamp a requested page size; 0 when the request does not ask for pages
+export const pageSize = value => {
+  const size = parseInt(value, 10);
+  return size > 0 ? Math.min(size, MAX_PAGE_SIZE) : 0;
+};
+
+/**
+ * JSON body of one page: { steps: [...], ...fields }, with raw steps
+ * copied as they are.
+ */
+export const pageBody = (steps, fields) => {
+  const text = steps.map(step => (typeof step === 'string' ? step : JSON.stringify(step))).join(',');
+  const tail = JSON.stringify(fields).slice(1, -1);
+  return '{"steps":[' + text + ']' + (tail ? ',' + tail : '') + '}';
+};
+
+/**
+ * Answer with the first page of a trace session: { steps, session, done,
+ * ...extra }. Further pages come from POST /api/session/:id/next while
+ * the engine keeps the algorithm suspended in between.
+ */
+const sendFirstPage = async (res, name, args, extra, size) => {
+  const session = await openSession(name, args);
+  const page = await nextPage(session, size);
+  res.status(200).type('application/json');
+  res.end(pageBody(page.steps, { session: page.done ? null : session, done: page.done, ...extra }));
+};
+
+/**
+ * Run an algorithm and stream its steps into an HTTP response while it
+ * is still running, with no limit on the trace size.
+ *
+ * Clients that send `Accept: application/x-ndjson` get one step per line
+ * and can start animating as soon as the first lines arrive. Everyone
+ * else gets the usual JSON body, { steps: [...], ...extra }, written
+ * incrementally.
+ *
+ * A request body with `pageSize` asks for the trace in pages of that
+ * many steps instead (see sendFirstPage), where the engine supports it.
+ *
+ * Throws if the algorithm fails before any output was sent, so the
+ * caller can still answer with an error status. Failures after that are
+ * reported inside the stream. If the client goes away first, the
+ * algorithm is stopped and nothing more is written.
+ */
+export const sendSteps = async (res, name, args, extra = {}) => {
+  const size = pageSize(res.req.body && res.req.body.pageSize);
+  if (size > 0 && sessionsAvailable()) {
+    return sendFirstPage(res, name, args, extra, size);
+  }
+
+  const ndjson = (res.req.get('Accept') || '').includes('application/x-ndjson');
+  const decoder = new StepDecoder({ raw: true });
+  let started = false;
+  let count = 0;
+
+  // A paused engine would otherwise wait for a drain that never comes
+  const gone = new AbortController();
+  res.once('close', () => {
+    if (!res.writableFinished) gone.abort();
+  });
+
+  const start = () => {
+    started = true;
+    res.status(200).type(ndjson ? 'application/x-ndjson' : 'application/json');
+    if (!ndjson) res.write('{"steps":[');
+  };
+
+  // Returns a promise while the client is not keeping up
+  const write = steps => {
+    if (steps.length === 0 || gone.signal.aborted) return null;
+    if (!started) start();
+
+    let text = '';
+    for (const step of steps) {
+      const json = typeof step === 'string' ? step : JSON.stringify(step);
+      if (ndjson) {
+        text += json + '\n';
+      } else {
+        text += (count > 0 ? ',' : '') + json;
+      }
+      count++;
+    }
+    if (res.write(text)) return null;
+    return new Promise(resolve => {
+      const done = () => {
+        res.off('drain', done);
+        res.off('close', done);
+        resolve();
+      };
+      res.once('drain', done);
+      res.once('close', done);
+    });
+  };
+
+  const finish = error => {
+    if (gone.signal.aborted) return;
+    if (!started) start();
+    if (ndjson) {
+      if (error) res.write(JSON.stringify({ type: 'error', message: error.message }) + '\n');
+      res.end();
+      return;
+    }
+    const tail = error ? { ...extra, error: error.message } : extra;
+    const fields = JSON.stringify(tail).slice(1, -1);
+    res.end(']' + (fields ? ',' + fields : '') + '}');
+  };
+
+  try {
+    const { stderr } = await runAlgorithm(name, args, chunk => write(decoder.push(chunk)), gone.signal);
+    if (stderr) {
+      console.error('C++ program stderr:', stderr);
+    }
+    write(decoder.end());
+  } catch (error) {
+    if (gone.signal.aborted) return;
+    if (!started) throw error;
+    console.error(`Error while streaming ${name}:`, error);
+    finish(error);
+    return;
+  }
+
+  finish(null);
+};
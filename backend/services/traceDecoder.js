@@ -0,0 +1,290 @@
+/**
+ * Trace decoding for the two formats the C++ step writer emits
+ * (see cpp/step_writer.h for the byte layout):
+ *   - NDJSON: one step object per line
+ *   - Binary: "ATRC" header with a step-type dictionary, then 20-byte records
+ * StepDecoder accepts the trace in arbitrary chunks as they arrive, so
+ * steps can be forwarded before the algorithm finishes.
+ */
+
+const MAGIC = 'ATRC';
+const RECORD_SIZE = 20;
+const CONTINUATION = 0xffff;
+
+const FIELD_INT = 0;
+const FIELD_FLAG = 1;
+const FIELD_LIST = 2;
+const FIELD_PAIRS = 3;
+const FIELD_INT64 = 4;
+
+export const isBinaryTrace = buffer =>
+  buffer.length >= 4 && buffer.toString('latin1', 0, 4) === MAGIC;
+
+/**
+ * Parse the "ATRC" header. Returns the step types and the offset of the
+ * first record, or null if the buffer does not hold the whole header yet.
+ */
+export const decodeHeader = buffer => {
+  let offset = 8;
+  if (buffer.length < offset) return null;
+
+  const version = buffer.readUInt16LE(4);
+  const typeCount = buffer.readUInt16LE(6);
+  if (version !== 1) {
+    throw new Error(`Unsupported binary trace version ${version}`);
+  }
+
+  const readByte = () => {
+    if (offset >= buffer.length) throw new RangeError('incomplete header');
+    return buffer[offset++];
+  };
+  const readString = () => {
+    const length = readByte();
+    if (offset + length > buffer.length) throw new RangeError('incomplete header');
+    const text = buffer.toString('latin1', offset, offset + length);
+    offset += length;
+    return text;
+  };
+
+  try {
+    const types = [];
+    for (let t = 0; t < typeCount; t++) {
+      const name = readString();
+      const fieldCount = readByte();
+      const fields = [];
+      for (let f = 0; f < fieldCount; f++) {
+        const kind = readByte();
+        const field = { kind, name: readString() };
+        if (kind === FIELD_PAIRS) {
+          field.item1 = readString();
+          field.item2 = readString();
+        }
+        fields.push(field);
+      }
+      types.push({ name, fields });
+    }
+
+    const start = (offset + 3) & ~3;
+    return start <= buffer.length ? { types, offset: start } : null;
+  } catch (e) {
+    if (e instanceof RangeError) return null;
+    throw e;
+  }
+};
+
+/**
+ * Incremental decoder for either trace format.
+ * push(chunk) returns the steps completed by that chunk; end() returns
+ * whatever complete steps remain once the trace is finished.
+ * With { raw: true }, NDJSON steps are returned as their unparsed line
+ * text, for callers that only forward them.
+ */
+export class StepDecoder {
+  constructor({ raw = false } = {}) {
+    this.raw = raw;
+    this.format = null;
+    this.pending = Buffer.alloc(0);
+    this.types = null;
+  }
+
+  push(chunk) {
+    this.pending = this.pending.length ? Buffer.concat([this.pending, chunk]) : chunk;
+
+    if (this.format === null) {
+      if (this.pending.length < 4 && MAGIC.startsWith(this.pending.toString('latin1'))) {
+        return [];
+      }
+      this.format = isBinaryTrace(this.pending) ? 'binary' : 'json';
+    }
+
+    return this.format === 'binary' ? this.pushBinary() : this.pushJson(false);
+  }
+
+  end() {
+    return this.format === 'json' ? this.pushJson(true) : [];
+  }
+
+  takeLines(final) {
+    const cut = final ? this.pending.length : this.pending.lastIndexOf(0x0a) + 1;
+    const text = this.pending.toString('utf8', 0, cut);
+    this.pending = this.pending.subarray(cut);
+    return text.split('\n').filter(line => line.trim());
+  }
+
+  pushJson(final) {
+    if (this.raw) return this.takeLines(final);
+
+    const steps = [];
+    for (const line of this.takeLines(final)) {
+      try {
+        steps.push(JSON.parse(line));
+      } catch (e) {
+        console.warn('Skipping invalid JSON line:', line);
+      }
+    }
+    return steps;
+  }
+
+  pushBinary() {
+    if (!this.types) {
+      const header = decodeHeader(this.pending);
+      if (!header) return [];
+      this.types = header.types;
+      this.pending = this.pending.subarray(header.offset);
+    }
+
+    const buffer = this.pending;
+    const view = new DataView(buffer.buffer, buffer.byteOffset, buffer.length);
+    const available = Math.floor(buffer.length / RECORD_SIZE);
+    const steps = [];
+
+    let record = 0;
+    while (record < available) {
+      const decoded = this.decodeRecord(view, record, available);
+      if (!decoded) break;
+      if (decoded.step) steps.push(decoded.step);
+      record = decoded.next;
+    }
+
+    this.pending = buffer.subarray(record * RECORD_SIZE);
+    return steps;
+  }
+
+  /**
+   * Decode the step starting at `record`. Returns { step, next } or null
+   * when its continuation records have not arrived yet.
+   */
+  decodeRecord(view, record, available) {
+    let base = record * RECORD_SIZE;
+    const opcode = view.getUint16(base, true);
+    const mask = view.getUint16(base + 2, true);
+    let next = record + 1;
+
+    if (opcode === CONTINUATION) return { step: null, next };
+    const type = this.types[opcode - 1];
+
+    // Word stream: 4 words in this record, then 4 per continuation record
+    let word = 0;
+    let complete = true;
+    const read = () => {
+      if (word === 4) {
+        if (next >= available) {
+          complete = false;
+          return 0;
+        }
+        base = next * RECORD_SIZE;
+        next++;
+        word = 0;
+      }
+      return view.getInt32(base + 4 + 4 * word++, true);
+    };
+
+    const step = { type: type.name };
+    for (let f = 0; f < type.fields.length && complete; f++) {
+      if (!(mask & (1 << f))) continue;
+      const field = type.fields[f];
+
+      if (field.kind === FIELD_INT) {
+        step[field.name] = read();
+      } else if (field.kind === FIELD_FLAG) {
+        step[field.name] = read() !== 0;
+      } else if (field.kind === FIELD_LIST) {
+        const count = read();
+        const items = new Array(count);
+        for (let i = 0; i < count && complete; i++) items[i] = read();
+        step[field.name] = items;
+      } else if (field.kind === FIELD_PAIRS) {
+        const count = read();
+        const items = new Array(count);
+        for (let i = 0; i < count && complete; i++) {
+          const first = read();
+          items[i] = { [field.item1]: first, [field.item2]: read() };
+        }
+        step[field.name] = items;
+      } else if (field.kind === FIELD_INT64) {
+        const low = read() >>> 0;
+        step[field.name] = read() * 2 ** 32 + low;
+      }
+    }
+
+    return complete ? { step, next } : null;
+  }
+}
+
+/**
+ * Decode a complete trace in either format.
+ */
+export const parseSteps = stdout => {
+  const decoder = new StepDecoder();
+  const steps = decoder.push(Buffer.isBuffer(stdout) ? stdout : Buffer.from(stdout));
+  return steps.concat(decoder.end());
+};
+
+const SEEK_CHUNK = 1 << 16;
+
+/**
+ * Keyframe index of a complete trace written with --keyframes (see
+ * cpp/keyframes.h), as [{ step, offset }] in step order; null when the
+ * trace has no index. Only the end of the trace and the index are read.
+ */
+export const readKeyframeIndex = buffer => {
+  if (isBinaryTrace(buffer)) {
+    const header = decodeHeader(buffer);
+    const indexType = header.types.findIndex(type => type.name === 'trace_index');
+    const last = buffer.length - RECORD_SIZE;
+    if (indexType < 0 || last < header.offset || buffer.readUInt16LE(last) !== indexType + 1) {
+      return null;
+    }
+    const readInt64 = at => buffer.readInt32LE(at + 4) * 2 ** 32 + buffer.readUInt32LE(at);
+    const count = readInt64(last + 4);
+    const start = readInt64(last + 12);
+    const index = new Array(count);
+    for (let i = 0; i < count; i++) {
+      const at = start + i * RECORD_SIZE;
+      index[i] = { step: readInt64(at + 4), offset: readInt64(at + 12) };
+    }
+    return index;
+  }
+
+  const end = buffer.length - (buffer[buffer.length - 1] === 0x0a ? 1 : 0);
+  const lastLine = JSON.parse(buffer.toString('utf8', buffer.lastIndexOf(0x0a, end - 1) + 1, end));
+  if (lastLine.type !== 'trace_index') return null;
+  return buffer
+    .toString('utf8', lastLine.offset, end)
+    .split('\n')
+    .slice(0, lastLine.keyframes)
+    .map(line => {
+      const { step, offset } = JSON.parse(line);
+      return { step, offset };
+    });
+};
+
+/**
+ * Steps needed to show step `target` of a complete trace: { start, steps }
+ * where steps[0] is the last keyframe at or before target (step number
+ * `start`) and the rest lead up to and including target. Without a
+ * keyframe before target, start is 0 and the replay begins at the first
+ * step. Step numbers count every step of the trace, keyframes included.
+ */
+export const seekStep = (buffer, target, index = readKeyframeIndex(buffer)) => {
+  const binary = isBinaryTrace(buffer);
+  const header = binary ? decodeHeader(buffer) : null;
+  let start = 0;
+  let offset = binary ? header.offset : 0;
+  for (const entry of index || []) {
+    if (entry.step > target) break;
+    ({ step: start, offset } = entry);
+  }
+
+  const decoder = new StepDecoder();
+  decoder.format = binary ? 'binary' : 'json';
+  decoder.types = binary ? header.types : null;
+  let steps = [];
+  while (steps.length <= target - start && offset < buffer.length) {
+    const end = Math.min(offset + SEEK_CHUNK, buffer.length);
+    steps = steps.concat(decoder.push(buffer.subarray(offset, end)));
+    offset = end;
+  }
+  if (offset >= buffer.length) steps = steps.concat(decoder.end());
+  return { start, steps: steps.slice(0, target - start + 1) };
+};
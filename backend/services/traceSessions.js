@@ -0,0 +1,101 @@
+import crypto from 'crypto';
+import { EngineWorker, engineAvailable } from './enginePool.js';
+import { StepDecoder } from './traceDecoder.js';
+
+const isWindows = process.platform === 'win32';
+
+// Sessions not asked for a page within this time are closed
+const idleTimeout = parseInt(process.env.ENGINE_SESSION_IDLE_MS, 10) || 5 * 60 * 1000;
+
+/**
+ * Trace sessions: traces produced page by page, as far as the client
+ * reads them (see the session commands in cpp/engine.cpp). Each session
+ * is a suspended engine child, so it holds memory until it finishes, is
+ * closed or times out.
+ *
+ * Sessions belong to the engine connection that opened them, so they all
+ * go through one dedicated worker outside the pool, one command at a time.
+ */
+let worker = null;
+let queue = Promise.resolve();
+const sessions = new Map();    // id -> { decoder, timer }
+
+const forget = id => {
+  const session = sessions.get(id);
+  if (!session) return;
+  clearTimeout(session.timer);
+  sessions.delete(id);
+};
+
+const send = (name, args) => {
+  const result = queue.then(() => {
+    if (!worker) {
+      worker = new EngineWorker(() => {
+        // Its sessions died with it
+        worker = null;
+        for (const id of [...sessions.keys()]) forget(id);
+      });
+    }
+    return worker.run(name, args);
+  });
+  queue = result.catch(() => {});
+  return result;
+};
+
+const touch = id => {
+  const session = sessions.get(id);
+  clearTimeout(session.timer);
+  session.timer = setTimeout(() => closeSession(id), idleTimeout);
+  session.timer.unref();
+};
+
+// Windows engines have no sessions, and standalone programs cannot page
+export const sessionsAvailable = () => !isWindows && engineAvailable();
+
+/**
+ * Start a session for an algorithm; nothing runs until the first page.
+ * Returns its id.
+ */
+export const openSession = async (name, args) => {
+  const id = crypto.randomUUID();
+  await send('@open', [id, name, ...args]);
+  sessions.set(id, { decoder: new StepDecoder({ raw: true }), timer: null });
+  touch(id);
+  return id;
+};
+
+/**
+ * The next `count` steps of a session as { steps, done }, where steps are
+ * raw JSON lines for text traces. The session is closed once done.
+ * Returns null for an unknown (finished, closed or timed out) session.
+ */
+export const nextPage = async (id, count) => {
+  const session = sessions.get(id);
+  if (!session) return null;
+  touch(id);
+
+  let page;
+  try {
+    page = await send('@next', [id, count]);
+  } catch (error) {
+    forget(id);
+    throw error;
+  }
+
+  const steps = session.decoder.push(page.stdout);
+  if (page.more) {
+    return { steps, done: false };
+  }
+  forget(id);
+  return { steps: steps.concat(session.decoder.end()), done: true };
+};
+
+/**
+ * Stop a session early; false if there was no such session.
+ */
+export const closeSession = async id => {
+  if (!sessions.has(id)) return false;
+  forget(id);
+  await send('@close', [id]).catch(error => console.error(`Error closing session ${id}:`, error));
+  return true;
+};
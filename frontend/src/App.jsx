@@ -58,7 +58,9 @@ function App() {
     { value: 'bubble', label: 'Bubble Sort' },
     { value: 'selection', label: 'Selection Sort' },
     { value: 'insertion', label: 'Insertion Sort' },
-    { value: 'merge', label: 'Merge Sort' }
+    { value: 'merge', label: 'Merge Sort' },
+    { value: 'pdqsort', label: 'Pattern-Defeating Quicksort' },
+    { value: 'radix', label: 'Radix Sort (LSD)' }
   ];
 
   // Graph algorithms
@@ -9,7 +9,9 @@ function AlgorithmSelector({ selectedAlgorithm, onAlgorithmChange, disabled }) {
     { value: 'bubble', label: 'Bubble Sort' },
     { value: 'selection', label: 'Selection Sort' },
     { value: 'insertion', label: 'Insertion Sort' },
-    { value: 'merge', label: 'Merge Sort' }
+    { value: 'merge', label: 'Merge Sort' },
+    { value: 'pdqsort', label: 'Pattern-Defeating Quicksort' },
+    { value: 'radix', label: 'Radix Sort (LSD)' }
   ];
 
   return (